@@ -0,0 +1,90 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef BUFFERVIEW_H
+#define BUFFERVIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+Non-owning view of bytes, e.g. a request still in the connection's receive
+buffer. The owner must keep the bytes alive and unchanged while it is used.
+*/
+class BufferView
+{
+    public:
+        BufferView() = default;
+        BufferView(const uint8_t *data, size_t size)
+            : viewData(data), viewSize(size)
+        {
+        }
+        // implicit, so callers holding a vector need no changes
+        BufferView(const std::vector<uint8_t> &buffer)
+            : viewData(buffer.data()), viewSize(buffer.size())
+        {
+        }
+
+        const uint8_t *data() const
+        {
+            return viewData;
+        }
+        size_t size() const
+        {
+            return viewSize;
+        }
+        uint8_t operator[](size_t index) const
+        {
+            return viewData[index];
+        }
+        BufferView subview(size_t offset) const
+        {
+            return offset >= viewSize
+                ? BufferView() : BufferView(viewData + offset, viewSize - offset);
+        }
+        BufferView subview(size_t offset, size_t size) const
+        {
+            BufferView tail = subview(offset);
+            return size >= tail.viewSize ? tail : BufferView(tail.viewData, size);
+        }
+        std::vector<uint8_t> toVector() const
+        {
+            return std::vector<uint8_t>(viewData, viewData + viewSize);
+        }
+
+    private:
+        const uint8_t *viewData = nullptr;
+        size_t viewSize = 0;
+};
+
+#endif /* BUFFERVIEW_H */
@@ -35,9 +35,9 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "CommandHeader.h"
 #include "utils.h"
 
-void CommandHeader::parse(std::vector<uint8_t> &buffer)
+void CommandHeader::parse(BufferView buffer, size_t offset)
 {
-    uint32_t header = Utils::decodeFromLittleEndianBuffer(buffer);
+    uint32_t header = Utils::decodeFromLittleEndianBuffer(buffer, offset);
     fromUint32(header);
 }
 
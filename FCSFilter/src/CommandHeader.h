@@ -33,19 +33,27 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef COMMANDHEADER_H
 #define COMMANDHEADER_H
 
+#include "BufferView.h"
+
 #include <stddef.h>
+#include <stdint.h>
 #include <vector>
 
 class CommandHeader
 {
     public:
-        void parse(std::vector<uint8_t> &buffer);
+        void parse(BufferView buffer, size_t offset = 0);
         void encode(std::vector<uint8_t> &buffer);
         uint32_t toUint32();
         static size_t getRequiredSize()
         {
             return sizeof(uint32_t);
         }
+        // length field counts words in 11 bits
+        static constexpr size_t getMaxPayloadSize()
+        {
+            return 0x7FF * sizeof(uint32_t);
+        }
 
         uint8_t client = 0;
         uint8_t id = 0;
@@ -0,0 +1,305 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "CommandRegistry.h"
+#include "CryptoSessionPool.h"
+#include "FcsCommunication.h"
+#include "intel_fcs_structs.h"
+#include "Logger.h"
+#include "MessageHandler.h"
+#include "utils.h"
+#include "VerifierProtocol.h"
+
+#include <array>
+
+// without a response the server disconnects, emulating system console
+static void respond(
+    VerifierProtocol &verifierProtocol,
+    bool fcsCallSucceeded,
+    ResponseBuffer &&payload,
+    int32_t fcsStatus,
+    ResponseMessage &response)
+{
+    if (!fcsCallSucceeded)
+    {
+        return;
+    }
+    verifierProtocol.prepareResponseMessage(
+        std::move(payload), response, fcsStatus);
+}
+
+static void handleGetChipId(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    std::vector<uint8_t> chipId;
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::getChipId(chipId, fcsStatus);
+    respond(verifierProtocol, fcsCallSucceeded,
+        ResponseBuffer(std::move(chipId)), fcsStatus, response);
+}
+
+static void handleSigmaTeardown(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::sigmaTeardown(
+        verifierProtocol.getSigmaTeardownSessionId(), fcsStatus);
+    respond(verifierProtocol, fcsCallSucceeded,
+        ResponseBuffer(), fcsStatus, response);
+}
+
+static void handleCreateAttestationSubkey(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    ResponseBuffer payload;
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::createAttestationSubkey(
+        verifierProtocol.getIncomingPayload(), payload, fcsStatus);
+    respond(verifierProtocol, fcsCallSucceeded,
+        std::move(payload), fcsStatus, response);
+}
+
+static void handleGetMeasurement(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    ResponseBuffer payload;
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::getMeasurement(
+        verifierProtocol.getIncomingPayload(), payload, fcsStatus);
+    respond(verifierProtocol, fcsCallSucceeded,
+        std::move(payload), fcsStatus, response);
+}
+
+static void handleGetAttestationCertificate(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    ResponseBuffer payload;
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::getAttestationCertificate(
+        verifierProtocol.getCertificateRequest(), payload, fcsStatus);
+    if (fcsStatus == -1)
+    {
+        Logger::log("GET_ATTESTATION_CERTIFICATE not supported by the driver. Returning unknown command.");
+        verifierProtocol.prepareEmptyResponseMessage(response, unknownCommand);
+        return;
+    }
+    respond(verifierProtocol, fcsCallSucceeded,
+        std::move(payload), fcsStatus, response);
+}
+
+// passed to the mailbox as is, with the protocol's command code
+static void handleMailboxCommand(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    ResponseBuffer payload;
+    int32_t fcsStatus = 0;
+    bool fcsCallSucceeded = FcsCommunication::mailboxGeneric(
+        verifierProtocol.getCommandCode(),
+        verifierProtocol.getIncomingPayload(),
+        payload,
+        fcsStatus);
+    respond(verifierProtocol, fcsCallSucceeded,
+        std::move(payload), fcsStatus, response);
+}
+
+// lease outcomes other than FCS errors map to server return codes
+static void respondToLease(
+    VerifierProtocol &verifierProtocol,
+    CryptoSessionPool::Result result,
+    ResponseMessage &response)
+{
+    switch (result)
+    {
+        case CryptoSessionPool::success:
+            verifierProtocol.prepareEmptyResponseMessage(response, noError);
+            break;
+        case CryptoSessionPool::disabled:
+            verifierProtocol.prepareEmptyResponseMessage(
+                response, unknownCommand);
+            break;
+        case CryptoSessionPool::exhausted:
+            verifierProtocol.prepareEmptyResponseMessage(response, busy);
+            break;
+        case CryptoSessionPool::notLeased:
+            verifierProtocol.prepareEmptyResponseMessage(
+                response, genericError);
+            break;
+        case CryptoSessionPool::fcsError:
+        case CryptoSessionPool::deviceError:
+            break;
+    }
+}
+
+static void handleOpenCryptoSession(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    uint32_t sessionId = 0;
+    int32_t fcsStatus = 0;
+    CryptoSessionPool::Result result = CryptoSessionPool::acquire(
+        verifierProtocol.getConnectionToken(), sessionId, fcsStatus);
+    if (result == CryptoSessionPool::success)
+    {
+        std::vector<uint8_t> payload(WORD_SIZE);
+        Utils::encodeToLittleEndianBuffer(sessionId, payload);
+        verifierProtocol.prepareResponseMessage(
+            std::move(payload), response, noError);
+        return;
+    }
+    if (result == CryptoSessionPool::fcsError)
+    {
+        verifierProtocol.prepareEmptyResponseMessage(response, fcsStatus);
+        return;
+    }
+    respondToLease(verifierProtocol, result, response);
+}
+
+static void handleCloseCryptoSession(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response)
+{
+    respondToLease(verifierProtocol,
+        CryptoSessionPool::release(verifierProtocol.getConnectionToken(),
+            verifierProtocol.getCryptoSessionId()),
+        response);
+}
+
+static constexpr CommandInfo makeCommand(
+    uint32_t code,
+    const char *name,
+    int32_t payloadSize,
+    uint8_t reservedBytes,
+    uint32_t magic,
+    uint32_t maxResponseSize,
+    ResponseCache::Policy cache,
+    CommandHandler handler)
+{
+    CommandInfo command;
+    command.code = code;
+    command.name = name;
+    command.payloadSize = payloadSize;
+    command.reservedBytes = reservedBytes;
+    command.magic = magic;
+    command.maxResponseSize = maxResponseSize;
+    command.cache = cache;
+    command.handler = handler;
+    return command;
+}
+
+static const int32_t kAny = CommandInfo::kAnyPayloadSize;
+
+static const uint32_t kChipIdSize = 2 * WORD_SIZE;
+static const uint32_t kIdCodeSize = WORD_SIZE;
+static const uint32_t kSessionIdSize = WORD_SIZE;
+
+// cache policies: cacheable, side effect free, ttl, dropped on events
+static constexpr ResponseCache::Policy kUncached = { false, false, 0, 0 };
+// answered the same for the whole boot
+static constexpr ResponseCache::Policy kBootConstant =
+    { true, true, 0, ResponseCache::deviceReset };
+static constexpr ResponseCache::Policy kCertificate = { true, true, 0,
+    ResponseCache::certificateReload | ResponseCache::deviceReset };
+
+// first entry stands for unknown codes
+static constexpr CommandInfo kCommands[] =
+{
+    CommandInfo(),
+    makeCommand(getIdCode, "GET_IDCODE", 0, 0, 0, kIdCodeSize,
+        kBootConstant, handleMailboxCommand),
+    makeCommand(getChipId, "GET_CHIPID", 0, 0, 0, kChipIdSize,
+        kBootConstant, handleGetChipId),
+    makeCommand(sigmaTeardown, "SIGMA_TEARDOWN", 8, RESERVED_BYTES_COUNT,
+        SIGMA_TEARDOWN_MAGIC, 0,
+        kUncached, handleSigmaTeardown),
+    makeCommand(getAttestationCertificate, "GET_ATTESTATION_CERTIFICATE", 4, 0, 0,
+        ATTESTATION_CERTIFICATE_RSP_MAX_SZ,
+        kCertificate, handleGetAttestationCertificate),
+    makeCommand(createAttestationSubKey, "CREATE_ATTESTATION_SUBKEY", kAny,
+        RESERVED_BYTES_COUNT, 0, ATTESTATION_SUBKEY_RSP_MAX_SZ,
+        kUncached, handleCreateAttestationSubkey),
+    makeCommand(getMeasurement, "GET_MEASUREMENT", kAny, RESERVED_BYTES_COUNT, 0,
+        ATTESTATION_MEASUREMENT_RSP_MAX_SZ,
+        kUncached, handleGetMeasurement),
+    makeCommand(mctp, "MCTP", kAny, 0, 0, MBOX_SEND_RSP_MAX_SZ,
+        kUncached, handleMailboxCommand),
+    makeCommand(getDeviceIdentity, "GET_DEVICE_IDENTITY", 0, 0, 0,
+        MBOX_SEND_RSP_MAX_SZ,
+        kBootConstant, handleMailboxCommand),
+    makeCommand(batchRequest, "BATCH", kAny, 0, 0,
+        CommandHeader::getMaxPayloadSize(),
+        kUncached, handleBatchMessage),
+    makeCommand(openCryptoSession, "OPEN_CRYPTO_SESSION", 0, 0, 0,
+        kSessionIdSize,
+        kUncached, handleOpenCryptoSession),
+    makeCommand(closeCryptoSession, "CLOSE_CRYPTO_SESSION", 4, 0, 0, 0,
+        kUncached, handleCloseCryptoSession),
+};
+
+static constexpr size_t kCommandCount = sizeof(kCommands) / sizeof(kCommands[0]);
+static_assert(kCommandCount <= 256, "command index holds 8 bits");
+
+static constexpr bool areCodesValid()
+{
+    for (size_t i = 1; i < kCommandCount; i++)
+    {
+        if (kCommands[i].code >= CommandRegistry::kCodeSpace)
+        {
+            return false;
+        }
+        for (size_t j = 1; j < i; j++)
+        {
+            if (kCommands[j].code == kCommands[i].code)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(areCodesValid(), "command codes must be unique and fit in 11 bits");
+
+// position in kCommands of each code, 0 for unknown ones
+static constexpr std::array<uint8_t, CommandRegistry::kCodeSpace> buildIndex()
+{
+    std::array<uint8_t, CommandRegistry::kCodeSpace> index {};
+    for (size_t i = 1; i < kCommandCount; i++)
+    {
+        index[kCommands[i].code] = static_cast<uint8_t>(i);
+    }
+    return index;
+}
+static constexpr std::array<uint8_t, CommandRegistry::kCodeSpace> kIndex =
+    buildIndex();
+
+const CommandInfo &CommandRegistry::get(uint32_t code)
+{
+    return kCommands[code < kCodeSpace ? kIndex[code] : 0];
+}
@@ -0,0 +1,87 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef COMMANDREGISTRY_H
+#define COMMANDREGISTRY_H
+
+#include "ResponseCache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+class ResponseMessage;
+class VerifierProtocol;
+
+// handles a parsed request; leaves the response empty to disconnect
+typedef void (*CommandHandler)(
+    VerifierProtocol &verifierProtocol, ResponseMessage &response);
+
+struct CommandInfo
+{
+    // payload of any size is accepted
+    static const int32_t kAnyPayloadSize = -1;
+
+    uint32_t code = 0;
+    const char *name = nullptr;
+    // payload size in bytes after the reserved bytes
+    int32_t payloadSize = kAnyPayloadSize;
+    // skipped between the command header and the payload
+    uint8_t reservedBytes = 0;
+    // first payload word must hold it, 0 when not checked
+    uint32_t magic = 0;
+    // largest response payload in bytes, e.g. to reserve room in a batch
+    uint32_t maxResponseSize = 0;
+    // how the response is cached, not at all by default
+    ResponseCache::Policy cache = {};
+    // nullptr for unknown codes
+    CommandHandler handler = nullptr;
+};
+
+/*
+Everything the server knows about each CommandCode in one table: how its
+request is parsed and checked, how its response is cached and which
+handler calls FCS for it. Lookup indexes a dense array over the 11 bit
+code space, built at compile time. Adding a command means adding its
+entry to the table in CommandRegistry.cpp.
+*/
+class CommandRegistry
+{
+    public:
+        // CommandHeader.code has 11 bits
+        static const size_t kCodeSpace = 1 << 11;
+
+        // entry without handler for unknown codes
+        static const CommandInfo &get(uint32_t code);
+};
+
+#endif /* COMMANDREGISTRY_H */
@@ -0,0 +1,280 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+
+#include "CryptoSessionPool.h"
+#include "FcsCommunication.h"
+#include "Logger.h"
+#include "Statistics.h"
+
+#include <string>
+
+std::mutex CryptoSessionPool::sessionsMutex;
+std::vector<uint32_t> CryptoSessionPool::idleSessions;
+std::unordered_map<uint32_t, uint64_t> CryptoSessionPool::leases;
+uint32_t CryptoSessionPool::openingSessions = 0;
+uint32_t CryptoSessionPool::maxSessions = 0;
+
+void CryptoSessionPool::setMaxSessions(uint32_t count)
+{
+    std::vector<uint32_t> excessSessions;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        maxSessions = count;
+        while (!idleSessions.empty()
+            && idleSessions.size() + leases.size() > maxSessions)
+        {
+            excessSessions.push_back(idleSessions.back());
+            idleSessions.pop_back();
+        }
+        updateGauges();
+    }
+    for (uint32_t sessionId : excessSessions)
+    {
+        close(sessionId);
+    }
+}
+
+bool CryptoSessionPool::fill()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            if (idleSessions.size() + leases.size() + openingSessions
+                >= maxSessions)
+            {
+                return true;
+            }
+            openingSessions++;
+        }
+        if (!openIdleSession())
+        {
+            return false;
+        }
+    }
+}
+
+CryptoSessionPool::Result CryptoSessionPool::acquire(
+    uint64_t owner, uint32_t &sessionId, int32_t &fcsStatus)
+{
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        if (maxSessions == 0)
+        {
+            return disabled;
+        }
+        if (!idleSessions.empty())
+        {
+            sessionId = idleSessions.back();
+            idleSessions.pop_back();
+            leases[sessionId] = owner;
+            Statistics::increment(Statistics::cryptoSessionsLeases);
+            updateGauges();
+            return success;
+        }
+        if (leases.size() + openingSessions >= maxSessions)
+        {
+            Statistics::increment(Statistics::cryptoSessionsExhausted);
+            return exhausted;
+        }
+        openingSessions++;
+    }
+    // the mailbox round trip runs unlocked, other leases go on meanwhile
+    bool opened = open(sessionId, fcsStatus);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    openingSessions--;
+    if (!opened)
+    {
+        return fcsStatus != 0 ? fcsError : deviceError;
+    }
+    leases[sessionId] = owner;
+    Statistics::increment(Statistics::cryptoSessionsLeases);
+    updateGauges();
+    return success;
+}
+
+CryptoSessionPool::Result CryptoSessionPool::release(
+    uint64_t owner, uint32_t sessionId)
+{
+    // a returned session is never lent again, its keys and contexts
+    // must not reach the next client
+    bool replacing = false;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto itr = leases.find(sessionId);
+        if (itr == leases.end() || itr->second != owner)
+        {
+            return maxSessions == 0 ? disabled : notLeased;
+        }
+        leases.erase(itr);
+        replacing = idleSessions.size() + leases.size() + openingSessions
+            < maxSessions;
+        if (replacing)
+        {
+            openingSessions++;
+        }
+        updateGauges();
+    }
+    close(sessionId);
+    if (replacing)
+    {
+        openIdleSession();
+    }
+    return success;
+}
+
+void CryptoSessionPool::releaseAll(uint64_t owner)
+{
+    std::vector<uint32_t> reclaimedSessions;
+    uint32_t replacements = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        for (auto itr = leases.begin(); itr != leases.end();)
+        {
+            if (itr->second != owner)
+            {
+                itr++;
+                continue;
+            }
+            reclaimedSessions.push_back(itr->first);
+            itr = leases.erase(itr);
+            if (idleSessions.size() + leases.size() + openingSessions
+                < maxSessions)
+            {
+                openingSessions++;
+                replacements++;
+            }
+        }
+        if (reclaimedSessions.empty())
+        {
+            return;
+        }
+        Logger::log("Reclaimed " + std::to_string(reclaimedSessions.size())
+            + " crypto session(s) of a closed connection", Debug);
+        Statistics::increment(Statistics::cryptoSessionsReclaimed,
+            reclaimedSessions.size());
+        updateGauges();
+    }
+    // closed first, SDM limits how many sessions are open at once
+    for (uint32_t sessionId : reclaimedSessions)
+    {
+        close(sessionId);
+    }
+    for (uint32_t i = 0; i < replacements; i++)
+    {
+        openIdleSession();
+    }
+}
+
+bool CryptoSessionPool::hasLeases(uint64_t owner)
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    for (const auto &lease : leases)
+    {
+        if (lease.second == owner)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CryptoSessionPool::clear()
+{
+    std::vector<uint32_t> sessions;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        sessions.swap(idleSessions);
+        for (const auto &lease : leases)
+        {
+            sessions.push_back(lease.first);
+        }
+        leases.clear();
+        updateGauges();
+    }
+    for (uint32_t sessionId : sessions)
+    {
+        close(sessionId);
+    }
+}
+
+bool CryptoSessionPool::open(uint32_t &sessionId, int32_t &fcsStatus)
+{
+    fcsStatus = 0;
+    if (!FcsCommunication::openCryptoSession(sessionId, fcsStatus)
+        || fcsStatus != 0)
+    {
+        Logger::log("Crypto session could not be opened, FCS status: "
+            + std::to_string(fcsStatus), Error);
+        return false;
+    }
+    Statistics::increment(Statistics::cryptoSessionsOpened);
+    return true;
+}
+
+bool CryptoSessionPool::openIdleSession()
+{
+    uint32_t sessionId = 0;
+    int32_t fcsStatus = 0;
+    bool opened = open(sessionId, fcsStatus);
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    openingSessions--;
+    if (!opened)
+    {
+        return false;
+    }
+    idleSessions.push_back(sessionId);
+    updateGauges();
+    return true;
+}
+
+void CryptoSessionPool::close(uint32_t sessionId)
+{
+    int32_t fcsStatus = 0;
+    if (!FcsCommunication::closeCryptoSession(sessionId, fcsStatus)
+        || fcsStatus != 0)
+    {
+        Logger::log("Crypto session " + std::to_string(sessionId)
+            + " could not be closed, FCS status: "
+            + std::to_string(fcsStatus), Error);
+        return;
+    }
+    Statistics::increment(Statistics::cryptoSessionsClosed);
+}
+
+void CryptoSessionPool::updateGauges()
+{
+    Statistics::set(Statistics::cryptoSessionsIdle, idleSessions.size());
+    Statistics::set(Statistics::cryptoSessionsLeased, leases.size());
+}
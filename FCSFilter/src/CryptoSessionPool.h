@@ -0,0 +1,109 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+
+#ifndef CRYPTOSESSIONPOOL_H
+#define CRYPTOSESSIONPOOL_H
+
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+/*
+SDM crypto service sessions opened ahead of time and lent to clients, so
+a client does not pay the open and close mailbox round trips around each
+of its operations. Sessions are opened on demand up to maxSessions when
+the pool is empty.
+
+Lease contract: a lease belongs to the connection token that took it,
+which is unique across reactors. A session is never lent twice: when the
+client returns it, or its connection closes, it is closed and replaced by
+a newly opened one, so no keys or contexts pass from one client to the
+next. Session IDs are only valid in this process, so a connection holding
+leases is not handed over in a hot restart. clear() closes all sessions,
+lent ones included.
+*/
+class CryptoSessionPool
+{
+    public:
+        enum Result
+        {
+            success,
+            // maxSessions is 0
+            disabled,
+            // all sessions are lent
+            exhausted,
+            // session is not lent to this connection
+            notLeased,
+            // FCS answered with a non-zero status
+            fcsError,
+            // ioctl failed
+            deviceError
+        };
+
+        // 0 disables the pool, sessions above a lower maximum are
+        // closed as they come back
+        static void setMaxSessions(uint32_t count);
+        // opens sessions up to the maximum ahead of the first client,
+        // false when one could not be opened
+        static bool fill();
+        // fcsStatus is set with fcsError
+        static Result acquire(
+            uint64_t owner, uint32_t &sessionId, int32_t &fcsStatus);
+        // closes the session and opens a replacement
+        static Result release(uint64_t owner, uint32_t sessionId);
+        // closes all sessions lent to a connection that went away and
+        // opens replacements
+        static void releaseAll(uint64_t owner);
+        static bool hasLeases(uint64_t owner);
+        // closes idle and lent sessions, e.g. before the process exits
+        static void clear();
+
+    private:
+        static bool open(uint32_t &sessionId, int32_t &fcsStatus);
+        // caller counted the session in openingSessions
+        static bool openIdleSession();
+        static void close(uint32_t sessionId);
+        static void updateGauges();
+
+        static std::mutex sessionsMutex;
+        static std::vector<uint32_t> idleSessions;
+        // session ID to the connection token it is lent to
+        static std::unordered_map<uint32_t, uint64_t> leases;
+        // being opened outside the lock, counted against maxSessions
+        static uint32_t openingSessions;
+        static uint32_t maxSessions;
+};
+
+#endif /* CRYPTOSESSIONPOOL_H */
@@ -31,37 +31,64 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "FcsCommunication.h"
+#include "FcsDevice.h"
 #include "Logger.h"
+#include "ResponseCache.h"
+#include "Statistics.h"
+#include "VerifierProtocol.h"
 #include "utils.h"
 
 #include "intel_fcs-ioctl.h"
 #include "intel_fcs_structs.h"
 
-#include <fcntl.h>
+#include <chrono>
+#include <errno.h>
 #include <string>
 #include <sys/ioctl.h>
-#include <unistd.h>
 
-#define FCS_DEVICE_PATH "/dev/fcs"
+// pooled slabs are reused across clients and a failed attestation command
+// leaves its slab untouched, so no payload is sent along with its error status;
+// mailbox (and MCTP) responses carry the data the device returned either way
+static size_t getAttestationResponseSize(int32_t fcsStatus, uint32_t responseSize)
+{
+    return fcsStatus == 0 ? responseSize : 0;
+}
 
 bool FcsCommunication::sendIoctl(
     intel_fcs_dev_ioctl *data,
     unsigned long commandCode)
 {
     data->status = -1;
-    int deviceFileDescriptor = open(FCS_DEVICE_PATH, O_RDWR);
-    if (deviceFileDescriptor < 0)
+    FcsDevice::Handle device = FcsDevice::acquire();
+    if (device.fd < 0)
     {
         Logger::logWithReturnCode("Opening device failed.", errno, Error);
         return false;
     }
-    if (ioctl(deviceFileDescriptor, commandCode, data) < 0)
+    std::chrono::steady_clock::time_point startTime =
+        std::chrono::steady_clock::now();
+    int result = ioctl(device.fd, commandCode, data);
+    int ioctlError = errno;
+    // time in the mailbox, the executor counts time waiting for a worker
+    Statistics::increment(Statistics::deviceCommands);
+    Statistics::increment(Statistics::deviceServiceTimeTotalUs,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count());
+    bool deviceGone = result < 0 && FcsDevice::isDeviceGone(ioctlError);
+    FcsDevice::release(device, deviceGone);
+    if (deviceGone)
+    {
+        ResponseCache::invalidate(ResponseCache::deviceReset);
+    }
+    if (result < 0)
     {
-        close(deviceFileDescriptor);
-        Logger::logWithReturnCode("Ioctl failed.", errno, Error);
+        Logger::logWithReturnCode("Ioctl failed.", ioctlError, Error);
         return false;
     }
-    close(deviceFileDescriptor);
+    if (commandCode == INTEL_FCS_DEV_ATTESTATION_CERTIFICATE_RELOAD)
+    {
+        ResponseCache::invalidate(ResponseCache::certificateReload);
+    }
     Logger::logWithReturnCode("Ioctl success.", data->status, Debug);
     return true;
 }
@@ -69,7 +96,12 @@ bool FcsCommunication::sendIoctl(
 bool FcsCommunication::getChipId(
     std::vector<uint8_t> &outBuffer, int32_t &fcsStatus)
 {
-    Logger::log("Calling getChipId");
+    Logger::log("Calling getChipId", Debug);
+    ResponseCache::Lookup cached(CommandCode::getChipId, BufferView());
+    if (cached.hit(outBuffer, fcsStatus))
+    {
+        return true;
+    }
     intel_fcs_dev_ioctl data = {};
     if (!sendIoctl(&data, INTEL_FCS_DEV_CHIP_ID))
     {
@@ -85,13 +117,14 @@ bool FcsCommunication::getChipId(
         outBuffer,
         sizeof(data.com_paras.c_id.chip_id_low));
     fcsStatus = data.status;
+    cached.store(outBuffer, fcsStatus);
     return true;
 }
 
 bool FcsCommunication::sigmaTeardown(uint32_t sessionId, int32_t &fcsStatus)
 {
     Logger::log("Calling sigmaTeardown with session ID: "
-        + std::to_string(static_cast<int32_t>(sessionId)));
+        + std::to_string(static_cast<int32_t>(sessionId)), Debug);
     intel_fcs_dev_ioctl data = {};
     data.com_paras.tdown.teardown = true;
     data.com_paras.tdown.sid = sessionId;
@@ -104,12 +137,44 @@ bool FcsCommunication::sigmaTeardown(uint32_t sessionId, int32_t &fcsStatus)
     return true;
 }
 
+bool FcsCommunication::openCryptoSession(
+    uint32_t &sessionId, int32_t &fcsStatus)
+{
+    Logger::log("Calling openCryptoSession", Debug);
+    intel_fcs_dev_ioctl data = {};
+
+    if (!sendIoctl(&data, INTEL_FCS_DEV_CRYPTO_OPEN_SESSION))
+    {
+        return false;
+    }
+    fcsStatus = data.status;
+    sessionId = data.com_paras.s_session.sid;
+    return true;
+}
+
+bool FcsCommunication::closeCryptoSession(
+    uint32_t sessionId, int32_t &fcsStatus)
+{
+    Logger::log("Calling closeCryptoSession with session ID: "
+        + std::to_string(sessionId), Debug);
+    intel_fcs_dev_ioctl data = {};
+    data.com_paras.s_session.sid = sessionId;
+
+    if (!sendIoctl(&data, INTEL_FCS_DEV_CRYPTO_CLOSE_SESSION))
+    {
+        return false;
+    }
+    fcsStatus = data.status;
+    return true;
+}
+
 bool FcsCommunication::createAttestationSubkey(
-    std::vector<uint8_t> &inBuffer,
-    std::vector<uint8_t> &outBuffer,
+    BufferView inBuffer,
+    ResponseBuffer &outBuffer,
     int32_t &fcsStatus)
 {
-    Logger::log("Calling createAttestationSubkey");
+    Logger::log("Calling createAttestationSubkey", Debug);
+    outBuffer = ResponseBuffer::fromPool();
     outBuffer.resize(ATTESTATION_SUBKEY_RSP_MAX_SZ);
 
     intel_fcs_dev_ioctl data = {};
@@ -125,17 +190,19 @@ bool FcsCommunication::createAttestationSubkey(
         return false;
     }
 
-    outBuffer.resize(data.com_paras.subkey.rsp_data_sz);
+    outBuffer.resize(
+        getAttestationResponseSize(data.status, data.com_paras.subkey.rsp_data_sz));
     fcsStatus = data.status;
     return true;
 }
 
 bool FcsCommunication::getMeasurement(
-    std::vector<uint8_t> &inBuffer,
-    std::vector<uint8_t> &outBuffer,
+    BufferView inBuffer,
+    ResponseBuffer &outBuffer,
     int32_t &fcsStatus)
 {
-    Logger::log("Calling getMeasurement");
+    Logger::log("Calling getMeasurement", Debug);
+    outBuffer = ResponseBuffer::fromPool();
     outBuffer.resize(ATTESTATION_MEASUREMENT_RSP_MAX_SZ);
 
     intel_fcs_dev_ioctl data = {};
@@ -151,17 +218,25 @@ bool FcsCommunication::getMeasurement(
         return false;
     }
 
-    outBuffer.resize(data.com_paras.measurement.rsp_data_sz);
+    outBuffer.resize(
+        getAttestationResponseSize(data.status, data.com_paras.measurement.rsp_data_sz));
     fcsStatus = data.status;
     return true;
 }
 
 bool FcsCommunication::getAttestationCertificate(
     uint8_t certificateRequest,
-    std::vector<uint8_t> &outBuffer,
+    ResponseBuffer &outBuffer,
     int32_t &fcsStatus)
 {
-    Logger::log("Calling getAttestationCertificate");
+    Logger::log("Calling getAttestationCertificate", Debug);
+    ResponseCache::Lookup cached(CommandCode::getAttestationCertificate,
+        BufferView(&certificateRequest, sizeof(certificateRequest)));
+    if (cached.hit(outBuffer, fcsStatus))
+    {
+        return true;
+    }
+    outBuffer = ResponseBuffer::fromPool();
     outBuffer.resize(ATTESTATION_CERTIFICATE_RSP_MAX_SZ);
 
     intel_fcs_dev_ioctl data = {};
@@ -175,18 +250,27 @@ bool FcsCommunication::getAttestationCertificate(
         return false;
     }
 
-    outBuffer.resize(data.com_paras.certificate.rsp_data_sz);
+    outBuffer.resize(
+        getAttestationResponseSize(data.status, data.com_paras.certificate.rsp_data_sz));
     fcsStatus = data.status;
+    cached.store(outBuffer, fcsStatus);
     return true;
 }
 
 bool FcsCommunication::mailboxGeneric(
     uint32_t commandCode,
-    std::vector<uint8_t> &inBuffer,
-    std::vector<uint8_t> &outBuffer,
+    BufferView inBuffer,
+    ResponseBuffer &outBuffer,
     int32_t &fcsStatus)
 {
-    Logger::log("Calling mailbox generic command with code: " + std::to_string(commandCode));
+    Logger::log("Calling mailbox generic command with code: " + std::to_string(commandCode), Debug);
+    // mailbox codes are the verifier command codes, e.g. GET_IDCODE
+    ResponseCache::Lookup cached(commandCode, inBuffer);
+    if (cached.hit(outBuffer, fcsStatus))
+    {
+        return true;
+    }
+    outBuffer = ResponseBuffer::fromPool();
     outBuffer.resize(MBOX_SEND_RSP_MAX_SZ);
 
     intel_fcs_dev_ioctl data = {};
@@ -202,8 +286,9 @@ bool FcsCommunication::mailboxGeneric(
     {
         return false;
     }
-    Logger::log("Received data from mailbox. Bytes: " + std::to_string(data.com_paras.mbox_send_cmd.rsp_data_sz));
+    Logger::log("Received data from mailbox. Bytes: " + std::to_string(data.com_paras.mbox_send_cmd.rsp_data_sz), Debug);
     outBuffer.resize(data.com_paras.mbox_send_cmd.rsp_data_sz);
     fcsStatus = data.status;
+    cached.store(outBuffer, fcsStatus);
     return true;
 }
@@ -37,6 +37,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stddef.h>
 #include <vector>
 
+#include "BufferView.h"
+#include "ResponseBuffer.h"
 #include "intel_fcs-ioctl.h"
 #include "intel_fcs_structs.h"
 
@@ -48,22 +50,24 @@ class FcsCommunication
             int32_t &fcsStatus);
         static bool sigmaTeardown(uint32_t sessionId, int32_t &fcsStatus);
         static bool createAttestationSubkey(
-            std::vector<uint8_t> &inBuffer,
-            std::vector<uint8_t> &outBuffer,
+            BufferView inBuffer,
+            ResponseBuffer &outBuffer,
             int32_t &fcsStatus);
         static bool getMeasurement(
-            std::vector<uint8_t> &inBuffer,
-            std::vector<uint8_t> &outBuffer,
+            BufferView inBuffer,
+            ResponseBuffer &outBuffer,
             int32_t &fcsStatus);
         static bool getAttestationCertificate(
             uint8_t certificateRequest,
-            std::vector<uint8_t> &outBuffer,
+            ResponseBuffer &outBuffer,
             int32_t &fcsStatus);
         static bool mailboxGeneric(
             uint32_t commandCode,
-            std::vector<uint8_t> &inBuffer,
-            std::vector<uint8_t> &outBuffer,
+            BufferView inBuffer,
+            ResponseBuffer &outBuffer,
             int32_t &fcsStatus);
+        static bool openCryptoSession(uint32_t &sessionId, int32_t &fcsStatus);
+        static bool closeCryptoSession(uint32_t sessionId, int32_t &fcsStatus);
 
     private:
         static bool sendIoctl(intel_fcs_dev_ioctl *data, unsigned long commandCode);
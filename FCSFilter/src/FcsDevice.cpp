@@ -0,0 +1,142 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "FcsDevice.h"
+#include "Logger.h"
+#include "Statistics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::mutex FcsDevice::handlesMutex;
+std::vector<int> FcsDevice::idleHandles;
+uint32_t FcsDevice::pooledHandles = 0;
+uint32_t FcsDevice::maxOpenHandles = 1;
+std::string FcsDevice::path = "/dev/fcs";
+
+void FcsDevice::setMaxOpenHandles(uint32_t count)
+{
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    maxOpenHandles = count;
+}
+
+void FcsDevice::setPath(const std::string &devicePath)
+{
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    path = devicePath;
+}
+
+FcsDevice::Handle FcsDevice::acquire()
+{
+    Handle handle;
+    {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        if (!idleHandles.empty())
+        {
+            handle.fd = idleHandles.back();
+            idleHandles.pop_back();
+            handle.pooled = true;
+            return handle;
+        }
+        handle.pooled = pooledHandles < maxOpenHandles;
+        if (handle.pooled)
+        {
+            pooledHandles++;
+        }
+    }
+    // the driver's open may be slow, others keep using kept descriptors
+    handle.fd = open();
+    if (handle.fd < 0 && handle.pooled)
+    {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        pooledHandles--;
+        handle.pooled = false;
+    }
+    return handle;
+}
+
+void FcsDevice::release(const Handle &handle, bool broken)
+{
+    if (handle.fd < 0)
+    {
+        return;
+    }
+    if (handle.pooled)
+    {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        if (!broken)
+        {
+            idleHandles.push_back(handle.fd);
+            return;
+        }
+        pooledHandles--;
+    }
+    if (broken)
+    {
+        Logger::log("Device handle dropped, reopening on next request", Warning);
+    }
+    close(handle.fd);
+}
+
+bool FcsDevice::isDeviceGone(int error)
+{
+    // e.g. driver unbound or reloaded; other errors are about the request
+    return error == ENODEV || error == ENXIO || error == EBADF;
+}
+
+void FcsDevice::closeIdle()
+{
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    for (int fd : idleHandles)
+    {
+        close(fd);
+    }
+    pooledHandles -= idleHandles.size();
+    idleHandles.clear();
+}
+
+int FcsDevice::open()
+{
+    std::string devicePath;
+    {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        devicePath = path;
+    }
+    int fd = ::open(devicePath.c_str(), O_RDWR);
+    if (fd >= 0)
+    {
+        Statistics::increment(Statistics::deviceOpens);
+    }
+    return fd;
+}
@@ -0,0 +1,84 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef FCSDEVICE_H
+#define FCSDEVICE_H
+
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+Keeps /dev/fcs open across requests instead of opening and closing it
+around every ioctl. A caller holds a descriptor for the duration of its
+ioctl, so no descriptor is ever closed under another thread. Up to
+maxOpenHandles descriptors are kept, e.g. one per request worker; callers
+beyond that at the same time get one opened just for their call. A
+descriptor whose ioctl says the device is gone is closed, and the next
+caller opens the device again.
+*/
+class FcsDevice
+{
+    public:
+        struct Handle
+        {
+            // -1 when the device could not be opened
+            int fd = -1;
+            // kept open after release
+            bool pooled = false;
+        };
+
+        static void setMaxOpenHandles(uint32_t count);
+        // /dev/fcs unless changed, e.g. to benchmark another device
+        static void setPath(const std::string &devicePath);
+        static Handle acquire();
+        // a broken handle is closed instead of kept
+        static void release(const Handle &handle, bool broken);
+        // errno of a failed ioctl meaning the descriptor is of no more use
+        static bool isDeviceGone(int error);
+        // closes the kept descriptors not in use
+        static void closeIdle();
+
+    private:
+        static int open();
+
+        static std::mutex handlesMutex;
+        static std::vector<int> idleHandles;
+        // idle and in use
+        static uint32_t pooledHandles;
+        static uint32_t maxOpenHandles;
+        static std::string path;
+};
+
+#endif /* FCSDEVICE_H */
@@ -35,12 +35,17 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Logger.h"
 
 LogLevel Logger::currentLogLevel=Info;
+std::mutex Logger::outputMutex;
 
 void Logger::log(std::string message, LogLevel level)
 {
     if (level >= currentLogLevel)
     {
-        std::cout << getLogLevelString(level) << message << std::endl;
+        // formatted before locking, the lock only covers the write;
+        // lines are flushed, the server ends with _exit
+        std::string line = getLogLevelString(level) + message + '\n';
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::flush;
     }
 }
 
@@ -48,9 +53,10 @@ void Logger::logWithReturnCode(std::string message, int errorCode, LogLevel leve
 {
     if (level >= currentLogLevel)
     {
-        std::cout
-            << getLogLevelString(level)
-            << message << " Return code: " << errorCode << std::endl;
+        std::string line = getLogLevelString(level) + message
+            + " Return code: " + std::to_string(errorCode) + '\n';
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::flush;
     }
 }
 
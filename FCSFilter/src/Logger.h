@@ -34,6 +34,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define LOGGER_H
 
 #include <iostream>
+#include <mutex>
 #include <string>
 
 enum LogLevel
@@ -61,6 +62,8 @@ class Logger
     private:
         static std::string getLogLevelString(LogLevel level);
         static LogLevel currentLogLevel;
+        // keeps lines from worker threads from interleaving
+        static std::mutex outputMutex;
 };
 
 #endif /* LOGGER_H */
@@ -0,0 +1,148 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "CommandHeader.h"
+#include "MessageFramer.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void MessageFramer::append(const uint8_t *data, size_t size)
+{
+    uint8_t *destination = getWritePointer(size);
+    std::copy(data, data + size, destination);
+    commitWrite(size);
+}
+
+uint8_t *MessageFramer::getWritePointer(size_t maxSize)
+{
+    compact();
+    if (buffer.size() < writeOffset + maxSize)
+    {
+        buffer.resize(writeOffset + maxSize);
+    }
+    return buffer.data() + writeOffset;
+}
+
+void MessageFramer::commitWrite(size_t size)
+{
+    if (writeOffset + size > buffer.size())
+    {
+        throw std::invalid_argument("commitWrite: size exceeds space reserved by getWritePointer");
+    }
+    writeOffset += size;
+}
+
+bool MessageFramer::nextFrame(std::vector<uint8_t> &frame)
+{
+    BufferView view;
+    if (!peekFrame(view))
+    {
+        return false;
+    }
+    frame.assign(view.data(), view.data() + view.size());
+    consumeFrame();
+    return true;
+}
+
+bool MessageFramer::peekFrame(BufferView &frame)
+{
+    if (expectedFrameSize == 0 && !readHeaderIfAvailable())
+    {
+        return false;
+    }
+    if (getBufferedSize() < expectedFrameSize)
+    {
+        return false;
+    }
+    frame = BufferView(buffer.data() + readOffset, expectedFrameSize);
+    return true;
+}
+
+void MessageFramer::consumeFrame()
+{
+    readOffset += expectedFrameSize;
+    expectedFrameSize = 0;
+}
+
+void MessageFramer::reset()
+{
+    buffer.clear();
+    readOffset = 0;
+    writeOffset = 0;
+    expectedFrameSize = 0;
+}
+
+std::vector<uint8_t> MessageFramer::detachBuffer()
+{
+    std::vector<uint8_t> detached;
+    detached.swap(buffer);
+    reset();
+    return detached;
+}
+
+bool MessageFramer::readHeaderIfAvailable()
+{
+    if (getBufferedSize() < CommandHeader::getRequiredSize())
+    {
+        return false;
+    }
+    CommandHeader header;
+    header.parse(buffer, readOffset);
+    expectedFrameSize = CommandHeader::getRequiredSize()
+        + header.length * WORD_SIZE;
+    return true;
+}
+
+void MessageFramer::compact()
+{
+    if (readOffset == writeOffset)
+    {
+        readOffset = 0;
+        writeOffset = 0;
+        return;
+    }
+    // in pipelined mode several complete frames may be left, so bytes are
+    // moved only once more of the buffer is consumed than left, which
+    // keeps copying linear in the bytes received
+    if (readOffset < buffer.size() / 2)
+    {
+        return;
+    }
+    std::copy(
+        buffer.begin() + readOffset,
+        buffer.begin() + writeOffset,
+        buffer.begin());
+    writeOffset -= readOffset;
+    readOffset = 0;
+}
@@ -0,0 +1,84 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef MESSAGEFRAMER_H
+#define MESSAGEFRAMER_H
+
+#include "BufferView.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+Reassembles verifier messages from a byte stream. A frame is a command header
+followed by header.length words, so several frames may arrive in one read
+and one frame may be split across several reads.
+*/
+class MessageFramer
+{
+    public:
+        void append(const uint8_t *data, size_t size);
+        // Lets the caller receive straight into the framer, without extra copy
+        uint8_t *getWritePointer(size_t maxSize);
+        void commitWrite(size_t size);
+
+        bool nextFrame(std::vector<uint8_t> &frame);
+        // Frame stays in the buffer and valid until consumeFrame,
+        // no data may be written meanwhile
+        bool peekFrame(BufferView &frame);
+        void consumeFrame();
+        size_t getBufferedSize()
+        {
+            return writeOffset - readOffset;
+        }
+        // bytes received and not consumed yet, valid until the next write
+        BufferView getBufferedData()
+        {
+            return BufferView(buffer.data() + readOffset, getBufferedSize());
+        }
+        void reset();
+        // Hands over the buffer, so a frame still in use survives reset
+        std::vector<uint8_t> detachBuffer();
+
+    private:
+        bool readHeaderIfAvailable();
+        void compact();
+
+        std::vector<uint8_t> buffer;
+        size_t readOffset = 0;
+        size_t writeOffset = 0;
+        // 0 while waiting for the command header of the next frame
+        size_t expectedFrameSize = 0;
+};
+
+#endif /* MESSAGEFRAMER_H */
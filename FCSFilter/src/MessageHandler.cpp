@@ -32,101 +32,129 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "MessageHandler.h"
-#include "FcsCommunication.h"
+#include "CommandRegistry.h"
+#include "CryptoSessionPool.h"
 #include "Logger.h"
 #include "VerifierProtocol.h"
 
-void handleIncomingMessage(
-    std::vector<uint8_t> &messageBuffer,
-    std::vector<uint8_t> &responseBuffer)
+void handleBatchMessage(
+    VerifierProtocol &verifierProtocol,
+    ResponseMessage &response)
 {
-    VerifierProtocol verifierProtocol;
-    if (!verifierProtocol.parseMessage(messageBuffer))
+    std::vector<BufferView> subRequests;
+    if (!verifierProtocol.getBatchedRequests(subRequests))
     {
-        Logger::log("Couldn't parse incoming message", Error);
-        verifierProtocol.prepareResponseMessage(
-            std::vector<uint8_t>(), responseBuffer, verifierProtocol.getErrorCode());
+        verifierProtocol.prepareEmptyResponseMessage(
+            response, verifierProtocol.getErrorCode());
         return;
     }
 
-    std::vector<uint8_t> payloadFromFcs;
-    bool fcsCallSucceeded = false;
-    int32_t statusReturnedFromFcs;
-    switch (verifierProtocol.getCommandCode())
+    // room for the sub-responses, less one header for a final error
+    const size_t payloadRoom = CommandHeader::getMaxPayloadSize()
+        - CommandHeader::getRequiredSize();
+    std::vector<uint8_t> payload;
+    for (BufferView subRequest : subRequests)
     {
-        case getChipId:
-        {
-            fcsCallSucceeded = FcsCommunication::getChipId(
-                payloadFromFcs, statusReturnedFromFcs);
-        }
-        break;
-        case sigmaTeardown:
-        {
-            fcsCallSucceeded = FcsCommunication::sigmaTeardown(
-                verifierProtocol.getSigmaTeardownSessionId(),
-                statusReturnedFromFcs);
-        }
-        break;
-        case createAttestationSubKey:
-        {
-            fcsCallSucceeded = FcsCommunication::createAttestationSubkey(
-                verifierProtocol.getIncomingPayload(),
-                payloadFromFcs,
-                statusReturnedFromFcs);
-        }
-        break;
-        case getMeasurement:
-        {
-            fcsCallSucceeded = FcsCommunication::getMeasurement(
-                verifierProtocol.getIncomingPayload(),
-                payloadFromFcs,
-                statusReturnedFromFcs);
-        }
-        break;
-        case getAttestationCertificate:
+        /*
+        a request that may change device state runs only when its largest
+        response fits; side effect free reads run first and their response
+        is dropped after the fact when it does not fit
+        */
+        CommandHeader subHeader;
+        subHeader.parse(subRequest);
+        const CommandInfo &command = CommandRegistry::get(subHeader.code);
+        size_t reservedSize = command.cache.sideEffectFree
+            ? 0 : command.maxResponseSize;
+        bool batchFull = payload.size() + CommandHeader::getRequiredSize()
+            + reservedSize > payloadRoom;
+        ResponseMessage subResponse;
+        if (!batchFull)
         {
-            fcsCallSucceeded = FcsCommunication::getAttestationCertificate(
-                verifierProtocol.getCertificateRequest(),
-                payloadFromFcs,
-                statusReturnedFromFcs);
-            if (statusReturnedFromFcs == -1)
-            {
-                Logger::log("GET_ATTESTATION_CERTIFICATE not supported by the driver. Returning unknown command.");
-                verifierProtocol.prepareEmptyResponseMessage(
-                responseBuffer, unknownCommand);
-                return;
-            }
+            handleIncomingMessage(subRequest, subResponse,
+                verifierProtocol.getConnectionToken());
+            batchFull = payload.size() + subResponse.size() > payloadRoom;
         }
-        break;
-        case mctp:
-        case getIdCode:
-        case getDeviceIdentity:
+        if (subResponse.empty() || batchFull)
         {
-            fcsCallSucceeded = FcsCommunication::mailboxGeneric(
-                verifierProtocol.getCommandCode(),
-                verifierProtocol.getIncomingPayload(),
-                payloadFromFcs,
-                statusReturnedFromFcs);
+            /*
+            failed request would disconnect on its own, within a batch
+            only its sub-response reports the error
+            */
+            VerifierProtocol subProtocol;
+            subProtocol.parseMessage(subRequest);
+            subResponse = ResponseMessage();
+            subProtocol.prepareEmptyResponseMessage(subResponse, genericError);
         }
-        break;
-        default:
+        std::vector<uint8_t> encoded = subResponse.toVector();
+        payload.insert(payload.end(), encoded.begin(), encoded.end());
+        if (batchFull)
         {
-            Logger::log("Command code not recognized: "
-                + std::to_string(verifierProtocol.getCommandCode()));
-            verifierProtocol.prepareEmptyResponseMessage(
-                responseBuffer, unknownCommand);
-            return;
+            Logger::log("Batched responses exceed frame size, "
+                "remaining requests skipped", Error);
+            break;
         }
-        break;
     }
-    if (!fcsCallSucceeded)
+    verifierProtocol.prepareResponseMessage(
+        std::move(payload), response, noError);
+}
+
+void handleIncomingMessage(
+    BufferView messageBuffer,
+    ResponseMessage &response,
+    uint64_t connectionToken)
+{
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.setConnectionToken(connectionToken);
+    if (!verifierProtocol.parseMessage(messageBuffer))
     {
-        /*
-        don't prepare any message, server should disconnect
-        - emulates system console behavior
-        */
+        Logger::log("Couldn't parse incoming message", Error);
+        verifierProtocol.prepareResponseMessage(
+            std::vector<uint8_t>(), response, verifierProtocol.getErrorCode());
         return;
     }
-    verifierProtocol.prepareResponseMessage(
-        payloadFromFcs, responseBuffer, statusReturnedFromFcs);
+
+    const CommandInfo &command =
+        CommandRegistry::get(verifierProtocol.getCommandCode());
+    if (command.handler == nullptr)
+    {
+        Logger::log("Command code not recognized: "
+            + std::to_string(verifierProtocol.getCommandCode()));
+        verifierProtocol.prepareEmptyResponseMessage(response, unknownCommand);
+        return;
+    }
+    command.handler(verifierProtocol, response);
+}
+
+void handleClosedConnection(uint64_t connectionToken)
+{
+    CryptoSessionPool::releaseAll(connectionToken);
+}
+
+bool holdsConnectionState(uint64_t connectionToken)
+{
+    return CryptoSessionPool::hasLeases(connectionToken);
+}
+
+void handleShutdown()
+{
+    // SDM keeps sessions open after the process is gone
+    CryptoSessionPool::clear();
+}
+
+void handleBusyMessage(
+    BufferView messageBuffer,
+    ResponseMessage &response)
+{
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.parseMessage(messageBuffer);
+    verifierProtocol.prepareEmptyResponseMessage(response, busy);
+}
+
+void handleRetryLaterMessage(
+    BufferView messageBuffer,
+    ResponseMessage &response)
+{
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.parseMessage(messageBuffer);
+    verifierProtocol.prepareEmptyResponseMessage(response, retryLater);
 }
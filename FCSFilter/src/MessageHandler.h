@@ -33,5 +33,28 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <stdint.h>
 
-void handleIncomingMessage(std::vector<uint8_t> &messageBuffer,
-                           std::vector<uint8_t> &responseBuffer);
+#include "BufferView.h"
+#include "ResponseMessage.h"
+
+class VerifierProtocol;
+
+// messageBuffer is only read, e.g. straight from the receive buffer;
+// connectionToken identifies the client's connection, 0 for none
+void handleIncomingMessage(BufferView messageBuffer,
+                           ResponseMessage &response,
+                           uint64_t connectionToken = 0);
+// the connection is closed and none of its requests is in flight
+void handleClosedConnection(uint64_t connectionToken);
+// the connection holds crypto sessions, which are only valid in this process
+bool holdsConnectionState(uint64_t connectionToken);
+// the process is about to terminate
+void handleShutdown();
+// handler of batchRequest, each sub-request goes through handleIncomingMessage
+void handleBatchMessage(VerifierProtocol &verifierProtocol,
+                        ResponseMessage &response);
+// answers without calling FCS, for clients over their request rate
+void handleBusyMessage(BufferView messageBuffer,
+                       ResponseMessage &response);
+// answers without calling FCS, when the server sheds load
+void handleRetryLaterMessage(BufferView messageBuffer,
+                             ResponseMessage &response);
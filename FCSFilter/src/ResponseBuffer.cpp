@@ -0,0 +1,137 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "ResponseBuffer.h"
+#include "Statistics.h"
+
+#include <string.h>
+
+std::mutex ResponseBuffer::idleSlabsMutex;
+std::vector<uint8_t*> ResponseBuffer::idleSlabs;
+
+ResponseBuffer::ResponseBuffer(ResponseBuffer &&other)
+    : slab(other.slab), slabUsed(other.slabUsed),
+      vector(std::move(other.vector))
+{
+    other.slab = nullptr;
+    other.slabUsed = 0;
+}
+
+ResponseBuffer &ResponseBuffer::operator=(ResponseBuffer &&other)
+{
+    if (this != &other)
+    {
+        releaseSlab();
+        slab = other.slab;
+        slabUsed = other.slabUsed;
+        vector = std::move(other.vector);
+        other.slab = nullptr;
+        other.slabUsed = 0;
+    }
+    return *this;
+}
+
+ResponseBuffer::~ResponseBuffer()
+{
+    releaseSlab();
+}
+
+ResponseBuffer ResponseBuffer::fromPool()
+{
+    ResponseBuffer buffer;
+    {
+        std::lock_guard<std::mutex> lock(idleSlabsMutex);
+        if (!idleSlabs.empty())
+        {
+            buffer.slab = idleSlabs.back();
+            idleSlabs.pop_back();
+        }
+    }
+    if (buffer.slab == nullptr)
+    {
+        // default initialized, i.e. not zero filled
+        buffer.slab = new uint8_t[kSlabSize];
+        Statistics::increment(Statistics::responseBuffersAllocated);
+    }
+    buffer.slabUsed = kSlabSize;
+    return buffer;
+}
+
+void ResponseBuffer::resize(size_t size)
+{
+    if (slab == nullptr)
+    {
+        vector.resize(size);
+        return;
+    }
+    if (size <= kSlabSize)
+    {
+        slabUsed = size;
+        return;
+    }
+    // does not happen with ioctl responses, kept correct anyway
+    vector.assign(slab, slab + slabUsed);
+    releaseSlab();
+    vector.resize(size);
+}
+
+void ResponseBuffer::assign(BufferView bytes)
+{
+    if (slab != nullptr && bytes.size() <= kSlabSize)
+    {
+        memmove(slab, bytes.data(), bytes.size());
+        slabUsed = bytes.size();
+        return;
+    }
+    releaseSlab();
+    vector = bytes.toVector();
+}
+
+void ResponseBuffer::releaseSlab()
+{
+    if (slab == nullptr)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(idleSlabsMutex);
+        if (idleSlabs.size() < kMaxIdleSlabs)
+        {
+            idleSlabs.push_back(slab);
+            slab = nullptr;
+        }
+    }
+    delete[] slab;
+    slab = nullptr;
+    slabUsed = 0;
+}
@@ -0,0 +1,113 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef RESPONSEBUFFER_H
+#define RESPONSEBUFFER_H
+
+#include "BufferView.h"
+
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+Payload of a response. Device responses go into a slab of the largest
+ioctl response size, taken from a pool, so a request neither allocates nor
+zero fills a buffer only to shrink it afterwards. The buffer moves along
+with the response to the transport, and its slab goes back to the pool
+once the sent response is dropped. Other payloads simply wrap a vector.
+*/
+class ResponseBuffer
+{
+    public:
+        // largest *_RSP_MAX_SZ of the ioctls
+        static const size_t kSlabSize = 4096;
+        // idle slabs kept, beyond that released ones are freed
+        static const size_t kMaxIdleSlabs = 64;
+
+        ResponseBuffer() = default;
+        // takes over the vector's bytes without copying
+        explicit ResponseBuffer(std::vector<uint8_t> &&bytes)
+            : vector(std::move(bytes))
+        {
+        }
+        ResponseBuffer(ResponseBuffer &&other);
+        ResponseBuffer &operator=(ResponseBuffer &&other);
+        ResponseBuffer(const ResponseBuffer &) = delete;
+        ResponseBuffer &operator=(const ResponseBuffer &) = delete;
+        ~ResponseBuffer();
+
+        // kSlabSize bytes from the pool, contents left uninitialized
+        static ResponseBuffer fromPool();
+
+        uint8_t *data()
+        {
+            return slab != nullptr ? slab : vector.data();
+        }
+        const uint8_t *data() const
+        {
+            return slab != nullptr ? slab : vector.data();
+        }
+        size_t size() const
+        {
+            return slab != nullptr ? slabUsed : vector.size();
+        }
+        bool empty() const
+        {
+            return size() == 0;
+        }
+        // within a slab, bytes are neither initialized nor moved
+        void resize(size_t size);
+        void assign(BufferView bytes);
+        operator BufferView() const
+        {
+            return BufferView(data(), size());
+        }
+        std::vector<uint8_t> toVector() const
+        {
+            return std::vector<uint8_t>(data(), data() + size());
+        }
+
+    private:
+        void releaseSlab();
+
+        uint8_t *slab = nullptr;
+        size_t slabUsed = 0;
+        std::vector<uint8_t> vector;
+
+        static std::mutex idleSlabsMutex;
+        static std::vector<uint8_t*> idleSlabs;
+};
+
+#endif /* RESPONSEBUFFER_H */
@@ -0,0 +1,229 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "ResponseCache.h"
+#include "CommandRegistry.h"
+#include "Logger.h"
+#include "Statistics.h"
+
+std::mutex ResponseCache::entriesMutex;
+std::map<uint32_t, ResponseCache::Policy> ResponseCache::policies;
+std::map<ResponseCache::Key, ResponseCache::Entry> ResponseCache::entries;
+std::map<ResponseCache::Key, std::shared_ptr<ResponseCache::Flight>>
+    ResponseCache::flights;
+uint64_t ResponseCache::generation = 0;
+
+ResponseCache::Lookup::Lookup(uint32_t lookedUpCode, BufferView lookedUpArgument)
+    : commandCode(lookedUpCode), usesCache(isCacheUsed(lookedUpCode))
+{
+    if (!usesCache)
+    {
+        return;
+    }
+    argument = lookedUpArgument.toVector();
+    Statistics::increment(Statistics::cacheLookups);
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    generation = ResponseCache::generation;
+}
+
+ResponseCache::Lookup::~Lookup()
+{
+    if (flight)
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        finishFlight(Key(commandCode, argument), *flight);
+    }
+}
+
+bool ResponseCache::Lookup::hit(
+    std::vector<uint8_t> &payload, int32_t &fcsStatus)
+{
+    if (!usesCache)
+    {
+        return false;
+    }
+    Policy policy = getPolicy(commandCode);
+    if (!policy.cacheable && !policy.sideEffectFree)
+    {
+        return false;
+    }
+    Key key(commandCode, argument);
+    std::unique_lock<std::mutex> lock(entriesMutex);
+    if (policy.cacheable)
+    {
+        auto entry = entries.find(key);
+        if (entry != entries.end() && Clock::now() < entry->second.expiry)
+        {
+            payload = entry->second.payload;
+            fcsStatus = entry->second.fcsStatus;
+            Statistics::increment(Statistics::cacheHits);
+            return true;
+        }
+        Statistics::increment(Statistics::cacheMisses);
+    }
+    if (!policy.sideEffectFree)
+    {
+        return false;
+    }
+    // after a failed flight, the next waiter leads a new one
+    while (true)
+    {
+        auto leading = flights.find(key);
+        if (leading == flights.end())
+        {
+            flight = std::make_shared<Flight>();
+            flights[key] = flight;
+            return false;
+        }
+        std::shared_ptr<Flight> joined = leading->second;
+        joined->finishedCondition.wait(lock, [&joined]
+        {
+            return joined->finished;
+        });
+        if (joined->succeeded)
+        {
+            payload = joined->payload;
+            fcsStatus = joined->fcsStatus;
+            Statistics::increment(Statistics::cacheCoalesced);
+            return true;
+        }
+    }
+}
+
+bool ResponseCache::Lookup::hit(ResponseBuffer &payload, int32_t &fcsStatus)
+{
+    std::vector<uint8_t> cachedPayload;
+    if (!hit(cachedPayload, fcsStatus))
+    {
+        return false;
+    }
+    payload = ResponseBuffer(std::move(cachedPayload));
+    return true;
+}
+
+void ResponseCache::Lookup::store(BufferView payload, int32_t fcsStatus)
+{
+    if (!usesCache)
+    {
+        return;
+    }
+    Policy policy = getPolicy(commandCode);
+    Key key(commandCode, argument);
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    if (flight)
+    {
+        // waiters get the response even when it is not cached
+        flight->succeeded = true;
+        flight->payload = payload.toVector();
+        flight->fcsStatus = fcsStatus;
+        finishFlight(key, *flight);
+        flight.reset();
+    }
+    if (!policy.cacheable || fcsStatus != 0
+        || generation != ResponseCache::generation)
+    {
+        return;
+    }
+    Clock::time_point expiry = policy.ttlInSeconds == 0
+        ? Clock::time_point::max()
+        : Clock::now() + std::chrono::seconds(policy.ttlInSeconds);
+    entries[key] = Entry { payload.toVector(), fcsStatus, expiry };
+}
+
+void ResponseCache::setPolicy(uint32_t commandCode, const Policy &policy)
+{
+    if (!isCacheUsed(commandCode))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    policies[commandCode] = policy;
+}
+
+ResponseCache::Policy ResponseCache::getPolicy(uint32_t commandCode)
+{
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    return findPolicy(commandCode);
+}
+
+void ResponseCache::invalidate(Event event)
+{
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    generation++;
+    for (auto entry = entries.begin(); entry != entries.end();)
+    {
+        if (findPolicy(entry->first.first).invalidateOn & event)
+        {
+            entry = entries.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+    Statistics::increment(Statistics::cacheInvalidations);
+    Logger::log("Cached device responses dropped", Debug);
+}
+
+void ResponseCache::clear()
+{
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    generation++;
+    entries.clear();
+}
+
+bool ResponseCache::isCacheUsed(uint32_t commandCode)
+{
+    // registry is constant, so no lock is needed
+    const Policy &policy = CommandRegistry::get(commandCode).cache;
+    return policy.cacheable || policy.sideEffectFree;
+}
+
+ResponseCache::Policy ResponseCache::findPolicy(uint32_t commandCode)
+{
+    auto policy = policies.find(commandCode);
+    return policy != policies.end()
+        ? policy->second
+        : CommandRegistry::get(commandCode).cache;
+}
+
+void ResponseCache::finishFlight(const Key &key, Flight &flight)
+{
+    flight.finished = true;
+    flight.finishedCondition.notify_all();
+    auto leading = flights.find(key);
+    if (leading != flights.end() && leading->second.get() == &flight)
+    {
+        flights.erase(leading);
+    }
+}
@@ -0,0 +1,157 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include "BufferView.h"
+#include "ResponseBuffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/*
+Answers FCS calls whose result does not change while the device runs, such
+as the chip ID or an attestation certificate, without a mailbox round trip.
+Each command has its policy: whether it is cached, for how long, and which
+events drop it. Policies come from the command's CommandRegistry entry,
+setPolicy overrides them, e.g. from server options. Commands the registry
+neither caches nor coalesces never copy their argument or take the lock. Responses are keyed by
+command code and call argument, only those with FCS status 0 are kept.
+Identical calls of side effect free commands made at the same time share
+one device call (single flight): the first goes to the device, the others
+wait for its response, whether it is cached or not.
+*/
+class ResponseCache
+{
+    public:
+        // events dropping cached responses, as Policy::invalidateOn flags
+        enum Event
+        {
+            certificateReload = 1 << 0,
+            // device descriptor broke, e.g. driver reloaded
+            deviceReset = 1 << 1
+        };
+
+        struct Policy
+        {
+            bool cacheable;
+            // identical concurrent calls may share one device call
+            bool sideEffectFree;
+            // 0 keeps responses until an event drops them
+            uint32_t ttlInSeconds;
+            uint32_t invalidateOn;
+        };
+
+    private:
+        struct Flight;
+
+    public:
+        /*
+        One call through the cache. Remembers the cache state before the
+        device call, so a response fetched while an event dropped the
+        cache is not stored. A lookup that missed and was first to ask
+        leads the flight, which ends with store or, when the device call
+        failed, when the lookup goes out of scope.
+        */
+        class Lookup
+        {
+            public:
+                Lookup(uint32_t commandCode, BufferView argument);
+                ~Lookup();
+                // fills payload and status when cached, or when another
+                // identical call in flight got them; may wait for it
+                bool hit(std::vector<uint8_t> &payload, int32_t &fcsStatus);
+                bool hit(ResponseBuffer &payload, int32_t &fcsStatus);
+                void store(BufferView payload, int32_t fcsStatus);
+
+            private:
+                uint32_t commandCode;
+                // false for commands the registry neither caches nor coalesces
+                bool usesCache;
+                std::vector<uint8_t> argument;
+                uint64_t generation;
+                // set while this lookup leads a flight
+                std::shared_ptr<Flight> flight;
+        };
+
+        // ignored for commands whose registry entry is not cached
+        // or side effect free, they bypass the cache altogether
+        static void setPolicy(uint32_t commandCode, const Policy &policy);
+        static Policy getPolicy(uint32_t commandCode);
+        static void invalidate(Event event);
+        static void clear();
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+        typedef std::pair<uint32_t, std::vector<uint8_t>> Key;
+
+        struct Entry
+        {
+            std::vector<uint8_t> payload;
+            int32_t fcsStatus;
+            // time_point::max() when it does not expire
+            Clock::time_point expiry;
+        };
+
+        struct Flight
+        {
+            std::condition_variable finishedCondition;
+            bool finished = false;
+            // false when the leading device call failed
+            bool succeeded = false;
+            std::vector<uint8_t> payload;
+            int32_t fcsStatus = 0;
+        };
+
+        static bool isCacheUsed(uint32_t commandCode);
+        // called with entriesMutex held
+        static Policy findPolicy(uint32_t commandCode);
+        static void finishFlight(const Key &key, Flight &flight);
+
+        static std::mutex entriesMutex;
+        // set with setPolicy, other commands follow CommandRegistry
+        static std::map<uint32_t, Policy> policies;
+        static std::map<Key, Entry> entries;
+        static std::map<Key, std::shared_ptr<Flight>> flights;
+        // bumped by every invalidation
+        static uint64_t generation;
+};
+
+#endif /* RESPONSECACHE_H */
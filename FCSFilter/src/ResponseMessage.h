@@ -0,0 +1,122 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef RESPONSEMESSAGE_H
+#define RESPONSEMESSAGE_H
+
+#include "ResponseBuffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <vector>
+
+/*
+Response as encoded command header and FCS payload kept apart. The transport
+sends both with one sendmsg, so the payload is never copied behind the header.
+*/
+class ResponseMessage
+{
+    public:
+        // iovecs needed for a single message
+        static const size_t kMaxIovecs = 2;
+
+        void setHeader(uint32_t encodedHeader)
+        {
+            for (size_t i = 0; i < sizeof(header); i++)
+            {
+                header[i] = static_cast<uint8_t>(encodedHeader >> (8 * i));
+            }
+            headerSize = sizeof(header);
+        }
+        void setPayload(std::vector<uint8_t> &&payloadBuffer)
+        {
+            payload = ResponseBuffer(std::move(payloadBuffer));
+        }
+        // a pooled payload goes back to the pool with the response
+        void setPayload(ResponseBuffer &&payloadBuffer)
+        {
+            payload = std::move(payloadBuffer);
+        }
+        const ResponseBuffer &getPayload() const
+        {
+            return payload;
+        }
+        // empty response makes the server disconnect
+        bool empty() const
+        {
+            return headerSize == 0;
+        }
+        size_t size() const
+        {
+            return headerSize + payload.size();
+        }
+
+        // describes bytes from offset on, returns number of iovecs filled
+        size_t getIovecs(size_t offset, iovec *iovecs) const
+        {
+            size_t count = 0;
+            if (offset < headerSize)
+            {
+                iovecs[count].iov_base = const_cast<uint8_t*>(header + offset);
+                iovecs[count].iov_len = headerSize - offset;
+                count++;
+                offset = 0;
+            }
+            else
+            {
+                offset -= headerSize;
+            }
+            if (offset < payload.size())
+            {
+                iovecs[count].iov_base =
+                    const_cast<uint8_t*>(payload.data() + offset);
+                iovecs[count].iov_len = payload.size() - offset;
+                count++;
+            }
+            return count;
+        }
+        std::vector<uint8_t> toVector() const
+        {
+            std::vector<uint8_t> output(header, header + headerSize);
+            output.insert(output.end(),
+                payload.data(), payload.data() + payload.size());
+            return output;
+        }
+
+    private:
+        uint8_t header[4] = {};
+        size_t headerSize = 0;
+        ResponseBuffer payload;
+};
+
+#endif /* RESPONSEMESSAGE_H */
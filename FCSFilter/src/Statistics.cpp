@@ -0,0 +1,134 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "Statistics.h"
+
+const char *const Statistics::names[counterCount] =
+{
+    "cache.coalesced",
+    "cache.hits",
+    "cache.invalidations",
+    "cache.lookups",
+    "cache.misses",
+    "cryptoSessions.closed",
+    "cryptoSessions.exhausted",
+    "cryptoSessions.idle",
+    "cryptoSessions.leased",
+    "cryptoSessions.leases",
+    "cryptoSessions.opened",
+    "cryptoSessions.reclaimed",
+    "device.commands",
+    "device.opens",
+    "device.serviceTimeTotalUs",
+    "executor.queueDepth",
+    "executor.queueDepthMax",
+    "executor.requests",
+    "executor.requestsAccepted",
+    "executor.requestsRejectedBusy",
+    "executor.requestsShedPending",
+    "executor.requestsShedServiceTime",
+    "executor.responsesDropped",
+    "executor.serviceTimeTotalUs",
+    "executor.waitTimeMaxUs",
+    "executor.waitTimeTotalUs",
+    "responseBuffers.allocated",
+    "server.connections",
+    "server.connectionsHandedOver",
+};
+std::atomic<uint64_t> Statistics::values[counterCount];
+
+void Statistics::increment(Counter counter, uint64_t value)
+{
+    values[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Statistics::decrement(Counter counter, uint64_t value)
+{
+    std::atomic<uint64_t> &current = values[counter];
+    uint64_t expected = current.load(std::memory_order_relaxed);
+    while (!current.compare_exchange_weak(expected,
+        expected > value ? expected - value : 0, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Statistics::set(Counter counter, uint64_t value)
+{
+    values[counter].store(value, std::memory_order_relaxed);
+}
+
+void Statistics::setMax(Counter counter, uint64_t value)
+{
+    std::atomic<uint64_t> &current = values[counter];
+    uint64_t expected = current.load(std::memory_order_relaxed);
+    while (value > expected && !current.compare_exchange_weak(
+        expected, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t Statistics::get(Counter counter)
+{
+    return values[counter].load(std::memory_order_relaxed);
+}
+
+const char *Statistics::getName(Counter counter)
+{
+    return names[counter];
+}
+
+std::string Statistics::toString()
+{
+    std::string result;
+    for (uint32_t counter = 0; counter < counterCount; counter++)
+    {
+        uint64_t value = values[counter].load(std::memory_order_relaxed);
+        if (value == 0)
+        {
+            continue;
+        }
+        if (!result.empty())
+        {
+            result += " ";
+        }
+        result += std::string(names[counter]) + "=" + std::to_string(value);
+    }
+    return result;
+}
+
+void Statistics::reset()
+{
+    for (std::atomic<uint64_t> &value : values)
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+/*
+Process wide counters and gauges, safe to update from any thread.
+Each one is a fixed atomic slot, so updates on request paths take no lock
+and build no strings. Server logs them periodically, so queues and caches
+can be sized from logs.
+*/
+class Statistics
+{
+    public:
+        // sorted by logged name
+        enum Counter
+        {
+            cacheCoalesced,
+            cacheHits,
+            cacheInvalidations,
+            cacheLookups,
+            cacheMisses,
+            cryptoSessionsClosed,
+            cryptoSessionsExhausted,
+            cryptoSessionsIdle,
+            cryptoSessionsLeased,
+            cryptoSessionsLeases,
+            cryptoSessionsOpened,
+            cryptoSessionsReclaimed,
+            deviceCommands,
+            deviceOpens,
+            deviceServiceTimeTotalUs,
+            executorQueueDepth,
+            executorQueueDepthMax,
+            executorRequests,
+            executorRequestsAccepted,
+            executorRequestsRejectedBusy,
+            executorRequestsShedPending,
+            executorRequestsShedServiceTime,
+            executorResponsesDropped,
+            executorServiceTimeTotalUs,
+            executorWaitTimeMaxUs,
+            executorWaitTimeTotalUs,
+            responseBuffersAllocated,
+            serverConnections,
+            serverConnectionsHandedOver,
+            counterCount
+        };
+
+        static void increment(Counter counter, uint64_t value = 1);
+        static void decrement(Counter counter, uint64_t value = 1);
+        static void set(Counter counter, uint64_t value);
+        // keeps the highest value ever reported
+        static void setMax(Counter counter, uint64_t value);
+        static uint64_t get(Counter counter);
+        static const char *getName(Counter counter);
+        // "name=value" pairs sorted by name, zero values left out
+        static std::string toString();
+        static void reset();
+
+    private:
+        static const char *const names[counterCount];
+        static std::atomic<uint64_t> values[counterCount];
+};
+
+#endif /* STATISTICS_H */
@@ -34,7 +34,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils.h"
 #include "VerifierProtocol.h"
 
-bool VerifierProtocol::parseMessage(std::vector<uint8_t> &messageBuffer)
+bool VerifierProtocol::parseMessage(BufferView messageBuffer)
 {
     if (messageBuffer.size() < CommandHeader::getRequiredSize())
     {
@@ -56,6 +56,7 @@ bool VerifierProtocol::parseMessage(std::vector<uint8_t> &messageBuffer)
         return false;
     }
 
+    commandInfo = &CommandRegistry::get(incomingHeader.code);
     size_t payloadOffset = getPayloadOffset();
 
     if (messageBuffer.size() < payloadOffset)
@@ -65,9 +66,7 @@ bool VerifierProtocol::parseMessage(std::vector<uint8_t> &messageBuffer)
         return false;
     }
 
-    incomingPayload = std::vector<uint8_t>(
-        messageBuffer.begin() + payloadOffset,
-        messageBuffer.end());
+    incomingPayload = messageBuffer.subview(payloadOffset);
     if (!isPayloadSizeCorrect() || !isMagicWordCorrect())
     {
         return false;
@@ -78,21 +77,13 @@ bool VerifierProtocol::parseMessage(std::vector<uint8_t> &messageBuffer)
 
 size_t VerifierProtocol::getPayloadOffset()
 {
-    size_t messageReservedBytesCount = 0;
-    if (incomingHeader.code == sigmaTeardown
-        || incomingHeader.code == createAttestationSubKey
-        || incomingHeader.code == getMeasurement)
-    {
-        messageReservedBytesCount = RESERVED_BYTES_COUNT;
-    }
-
-    return CommandHeader::getRequiredSize() + messageReservedBytesCount;
+    return CommandHeader::getRequiredSize() + commandInfo->reservedBytes;
 }
 
 bool VerifierProtocol::isPayloadSizeCorrect()
 {
-    auto itr = payloadSizeMap.find(incomingHeader.code);
-    if (itr != payloadSizeMap.end() && itr->second != incomingPayload.size())
+    if (commandInfo->payloadSize != CommandInfo::kAnyPayloadSize
+        && size_t(commandInfo->payloadSize) != incomingPayload.size())
     {
         Logger::log("Message Size incorrect", Error);
         errorCode = invalidHeader;
@@ -103,17 +94,24 @@ bool VerifierProtocol::isPayloadSizeCorrect()
 
 bool VerifierProtocol::isMagicWordCorrect()
 {
-    if (incomingHeader.code == sigmaTeardown)
+    if (commandInfo->magic == 0)
     {
-        uint32_t incomingMagic = Utils::decodeFromLittleEndianBuffer(
-            incomingPayload);
-        if (incomingMagic != SIGMA_TEARDOWN_MAGIC)
-        {
-            Logger::log("Incorrect sigma teardown magic: "
-                + std::to_string(incomingMagic), Error);
-            errorCode = invalidMagic;
-            return false;
-        }
+        return true;
+    }
+    if (incomingPayload.size() < WORD_SIZE)
+    {
+        Logger::log("Message Size too small for magic word", Error);
+        errorCode = invalidHeader;
+        return false;
+    }
+    uint32_t incomingMagic = Utils::decodeFromLittleEndianBuffer(
+        incomingPayload);
+    if (incomingMagic != commandInfo->magic)
+    {
+        Logger::log("Incorrect " + std::string(commandInfo->name)
+            + " magic: " + std::to_string(incomingMagic), Error);
+        errorCode = invalidMagic;
+        return false;
     }
     return true;
 }
@@ -131,21 +129,15 @@ void VerifierProtocol::prepareResponseMessage(
     const int returnCode)
 {
     Logger::log("Preparing response with return code "
-        + std::to_string(returnCode));
-    if (payloadBuffer.size() % WORD_SIZE != 0)
+        + std::to_string(returnCode), Debug);
+    if (!isResponsePayloadSizeCorrect(payloadBuffer.size()))
     {
-        Logger::log("Payload size not divisible by word size", Error);
         prepareEmptyResponseMessage(responseBuffer, genericError);
         return;
     }
 
-    CommandHeader outgoingHeader;
-    outgoingHeader.client = incomingHeader.client;
-    outgoingHeader.id = incomingHeader.id;
-    outgoingHeader.length = payloadBuffer.size() / WORD_SIZE;
-    outgoingHeader.res1 = 0;
-    outgoingHeader.res2 = 0;
-    outgoingHeader.code = returnCode;
+    CommandHeader outgoingHeader = makeResponseHeader(
+        payloadBuffer.size(), returnCode);
 
     responseBuffer.reserve(CommandHeader::getRequiredSize() + payloadBuffer.size());
     responseBuffer.resize(CommandHeader::getRequiredSize());
@@ -164,6 +156,64 @@ void VerifierProtocol::prepareResponseMessage(
 
 }
 
+void VerifierProtocol::prepareEmptyResponseMessage(
+    ResponseMessage &response,
+    const int returnCode)
+{
+    prepareResponseMessage(std::vector<uint8_t>(), response, returnCode);
+}
+
+void VerifierProtocol::prepareResponseMessage(
+    std::vector<uint8_t> &&payloadBuffer,
+    ResponseMessage &response,
+    const int returnCode)
+{
+    prepareResponseMessage(
+        ResponseBuffer(std::move(payloadBuffer)), response, returnCode);
+}
+
+void VerifierProtocol::prepareResponseMessage(
+    ResponseBuffer &&payloadBuffer,
+    ResponseMessage &response,
+    const int returnCode)
+{
+    Logger::log("Preparing response with return code "
+        + std::to_string(returnCode), Debug);
+    if (!isResponsePayloadSizeCorrect(payloadBuffer.size()))
+    {
+        prepareEmptyResponseMessage(response, genericError);
+        return;
+    }
+
+    response.setHeader(
+        makeResponseHeader(payloadBuffer.size(), returnCode).toUint32());
+    response.setPayload(std::move(payloadBuffer));
+}
+
+bool VerifierProtocol::isResponsePayloadSizeCorrect(size_t payloadSize)
+{
+    if (payloadSize % WORD_SIZE != 0)
+    {
+        Logger::log("Payload size not divisible by word size", Error);
+        return false;
+    }
+    return true;
+}
+
+CommandHeader VerifierProtocol::makeResponseHeader(
+    size_t payloadSize,
+    const int returnCode)
+{
+    CommandHeader outgoingHeader;
+    outgoingHeader.client = incomingHeader.client;
+    outgoingHeader.id = incomingHeader.id;
+    outgoingHeader.length = payloadSize / WORD_SIZE;
+    outgoingHeader.res1 = 0;
+    outgoingHeader.res2 = 0;
+    outgoingHeader.code = returnCode;
+    return outgoingHeader;
+}
+
 uint32_t VerifierProtocol::getCommandCode()
 {
     return incomingHeader.code;
@@ -178,7 +228,8 @@ uint32_t VerifierProtocol::getSigmaTeardownSessionId()
     }
 
     //should never happen, as it is also checked during parsing
-    if (incomingPayload.size() < payloadSizeMap[sigmaTeardown])
+    if (incomingPayload.size()
+        < size_t(CommandRegistry::get(sigmaTeardown).payloadSize))
     {
         throw std::logic_error("getSigmaTeardownSessionId: Message Size too small");
     }
@@ -195,10 +246,68 @@ uint8_t VerifierProtocol::getCertificateRequest()
     }
 
     //should never happen, as it is also checked during parsing
-    if (incomingPayload.size() < payloadSizeMap[getAttestationCertificate])
+    if (incomingPayload.size()
+        < size_t(CommandRegistry::get(getAttestationCertificate).payloadSize))
     {
         throw std::logic_error("getCertificateRequest: Message Size too small");
     }
     uint32_t getAttCertPayload = Utils::decodeFromLittleEndianBuffer(incomingPayload);
     return  getAttCertPayload & GET_ATT_CERT_CERTIFICATE_REQUEST_MASK;
 }
+
+uint32_t VerifierProtocol::getCryptoSessionId()
+{
+    //should never happen
+    if (getCommandCode() != closeCryptoSession)
+    {
+        throw std::logic_error("Attempt to read crypto session ID from message of type other than closeCryptoSession");
+    }
+
+    //should never happen, as it is also checked during parsing
+    if (incomingPayload.size()
+        < size_t(CommandRegistry::get(closeCryptoSession).payloadSize))
+    {
+        throw std::logic_error("getCryptoSessionId: Message Size too small");
+    }
+    return Utils::decodeFromLittleEndianBuffer(incomingPayload);
+}
+
+bool VerifierProtocol::getBatchedRequests(std::vector<BufferView> &requests)
+{
+    //should never happen
+    if (getCommandCode() != batchRequest)
+    {
+        throw std::logic_error("Attempt to read batched requests from message of type other than batchRequest");
+    }
+
+    requests.clear();
+    size_t offset = 0;
+    while (offset < incomingPayload.size())
+    {
+        if (incomingPayload.size() - offset < CommandHeader::getRequiredSize())
+        {
+            Logger::log("Batched request shorter than Command Header", Error);
+            errorCode = invalidHeader;
+            return false;
+        }
+        CommandHeader header;
+        header.parse(incomingPayload, offset);
+        size_t requestSize = CommandHeader::getRequiredSize()
+            + header.length * WORD_SIZE;
+        if (incomingPayload.size() - offset < requestSize)
+        {
+            Logger::log("Batched request exceeds batch payload", Error);
+            errorCode = invalidHeader;
+            return false;
+        }
+        if (header.code == batchRequest)
+        {
+            Logger::log("Batch requests cannot be nested", Error);
+            errorCode = invalidHeader;
+            return false;
+        }
+        requests.push_back(incomingPayload.subview(offset, requestSize));
+        offset += requestSize;
+    }
+    return true;
+}
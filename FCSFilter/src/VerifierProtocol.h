@@ -33,11 +33,13 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef VERIFIERPROTOCOL_H
 #define VERIFIERPROTOCOL_H
 
+#include "BufferView.h"
 #include "CommandHeader.h"
+#include "CommandRegistry.h"
+#include "ResponseMessage.h"
 
 #include <stddef.h>
 #include <vector>
-#include <unordered_map>
 
 #define RESERVED_BYTES_COUNT 4
 #define SIGMA_TEARDOWN_MAGIC 0xb852e2a4
@@ -55,7 +57,12 @@ enum CommandCode
     createAttestationSubKey = 0x182,
     getMeasurement = 0x183,
     mctp = 0x194,
-    getDeviceIdentity = 0x500
+    getDeviceIdentity = 0x500,
+    // server extension, payload holds several framed requests
+    batchRequest = 0x7f0,
+    // server extensions, lend and return a pooled crypto service session
+    openCryptoSession = 0x7f1,
+    closeCryptoSession = 0x7f2
 };
 
 enum ErrorCode
@@ -64,13 +71,18 @@ enum ErrorCode
     genericError = 0x01,
     unknownCommand = 0x03,
     invalidHeader = 0x04,
+    // server refused the request, client is over its request rate
+    busy = 0x05,
+    // server is overloaded, request was not handled
+    retryLater = 0x06,
     invalidMagic = 0x80
 };
 
 class VerifierProtocol
 {
     public:
-        bool parseMessage(std::vector<uint8_t> &messageBuffer);
+        // payload is not copied, messageBuffer must outlive this object
+        bool parseMessage(BufferView messageBuffer);
         void prepareResponseMessage(
             std::vector<uint8_t> const &payloadBuffer,
             std::vector<uint8_t> &responseBuffer,
@@ -78,11 +90,26 @@ class VerifierProtocol
         void prepareEmptyResponseMessage(
             std::vector<uint8_t> &responseBuffer,
             const int returnCode);
+        // payload is moved into the response instead of copied
+        void prepareResponseMessage(
+            std::vector<uint8_t> &&payloadBuffer,
+            ResponseMessage &response,
+            const int returnCode);
+        void prepareResponseMessage(
+            ResponseBuffer &&payloadBuffer,
+            ResponseMessage &response,
+            const int returnCode);
+        void prepareEmptyResponseMessage(
+            ResponseMessage &response,
+            const int returnCode);
         uint32_t getCommandCode();
         uint32_t getSigmaTeardownSessionId();
         uint8_t getCertificateRequest();
+        uint32_t getCryptoSessionId();
+        // splits a batch into views of its sub-requests, false if malformed
+        bool getBatchedRequests(std::vector<BufferView> &requests);
 
-        std::vector<uint8_t> &getIncomingPayload()
+        BufferView getIncomingPayload()
         {
             return incomingPayload;
         }
@@ -90,22 +117,28 @@ class VerifierProtocol
         {
             return errorCode;
         }
+        // server connection the request came from, owns its crypto sessions
+        void setConnectionToken(uint64_t token)
+        {
+            connectionToken = token;
+        }
+        uint64_t getConnectionToken()
+        {
+            return connectionToken;
+        }
 
     private:
         bool isPayloadSizeCorrect();
         bool isMagicWordCorrect();
         size_t getPayloadOffset();
-        static inline std::unordered_map<uint32_t, size_t> payloadSizeMap =
-        {
-            { sigmaTeardown, 8 },
-            { getAttestationCertificate, 4 },
-            { getChipId, 0 },
-            { getDeviceIdentity, 0 },
-            { getIdCode, 0 },
-        };
-        std::vector<uint8_t> incomingPayload;
+        bool isResponsePayloadSizeCorrect(size_t payloadSize);
+        CommandHeader makeResponseHeader(size_t payloadSize, const int returnCode);
+        // registry entry of the incoming command, set while parsing
+        const CommandInfo *commandInfo = &CommandRegistry::get(0);
+        BufferView incomingPayload;
         CommandHeader incomingHeader;
         ErrorCode errorCode = genericError;
+        uint64_t connectionToken = 0;
 };
 
 #endif /* VERIFIERPROTOCOL_H */
@@ -33,6 +33,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "BufferView.h"
+
 #include <stdexcept>
 #include <stdint.h>
 #include <vector>
@@ -45,7 +47,7 @@ class Utils
 {
     public:
         static uint32_t decodeFromLittleEndianBuffer(
-            const std::vector<uint8_t> &buffer, size_t offset = 0)
+            BufferView buffer, size_t offset = 0)
         {
             if (buffer.size() < offset + WORD_SIZE)
             {
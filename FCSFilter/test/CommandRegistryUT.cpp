@@ -0,0 +1,68 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+
+#include "gtest/gtest.h"
+
+#include "CommandRegistry.h"
+#include "VerifierProtocol.h"
+
+TEST(CommandRegistryUT, knownCommandHasHandlerAndParsing)
+{
+    const CommandInfo &teardown = CommandRegistry::get(sigmaTeardown);
+    EXPECT_EQ((uint32_t)sigmaTeardown, teardown.code);
+    EXPECT_NE(nullptr, teardown.handler);
+    EXPECT_EQ(8, teardown.payloadSize);
+    EXPECT_EQ(RESERVED_BYTES_COUNT, teardown.reservedBytes);
+    EXPECT_EQ((uint32_t)SIGMA_TEARDOWN_MAGIC, teardown.magic);
+    EXPECT_FALSE(teardown.cache.cacheable);
+    EXPECT_FALSE(teardown.cache.sideEffectFree);
+
+    const CommandInfo &idCode = CommandRegistry::get(getIdCode);
+    EXPECT_TRUE(idCode.cache.cacheable);
+    EXPECT_TRUE(idCode.cache.sideEffectFree);
+    EXPECT_EQ((uint32_t)ResponseCache::deviceReset, idCode.cache.invalidateOn);
+    EXPECT_TRUE(CommandRegistry::get(getAttestationCertificate).cache.invalidateOn
+        & ResponseCache::certificateReload);
+    EXPECT_EQ((int32_t)CommandInfo::kAnyPayloadSize,
+        CommandRegistry::get(getMeasurement).payloadSize);
+}
+
+TEST(CommandRegistryUT, unknownCodeHasNoHandler)
+{
+    EXPECT_EQ(nullptr, CommandRegistry::get(0x11).handler);
+    EXPECT_EQ(nullptr,
+        CommandRegistry::get(CommandRegistry::kCodeSpace - 1).handler);
+    EXPECT_EQ(nullptr,
+        CommandRegistry::get(CommandRegistry::kCodeSpace + getChipId).handler);
+}
@@ -0,0 +1,168 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+
+#include "gtest/gtest.h"
+
+#include "ConnectionTable.h"
+#include "CryptoSessionPool.h"
+#include "FcsSimulator.h"
+#include "MessageHandler.h"
+
+TEST(CryptoSessionPoolUT, returnedSessionIsReplaced)
+{
+    uint32_t openBefore = FcsSimulator::openCryptoSessions;
+    CryptoSessionPool::setMaxSessions(2);
+    EXPECT_TRUE(CryptoSessionPool::fill());
+    EXPECT_EQ(openBefore + 2, FcsSimulator::openCryptoSessions);
+
+    uint32_t sessionId = 0;
+    int32_t status = -1;
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(1, sessionId, status));
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::release(1, sessionId));
+    EXPECT_EQ(openBefore + 2, FcsSimulator::openCryptoSessions);
+
+    //next client never gets the returned session
+    uint32_t secondSessionId = 0;
+    uint32_t thirdSessionId = 0;
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(2, secondSessionId, status));
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(3, thirdSessionId, status));
+    EXPECT_NE(sessionId, secondSessionId);
+    EXPECT_NE(sessionId, thirdSessionId);
+    CryptoSessionPool::release(3, thirdSessionId);
+
+    CryptoSessionPool::release(2, secondSessionId);
+    CryptoSessionPool::clear();
+    CryptoSessionPool::setMaxSessions(0);
+    EXPECT_EQ(openBefore, FcsSimulator::openCryptoSessions);
+}
+
+TEST(CryptoSessionPoolUT, leasesOfClosedConnectionAreReopened)
+{
+    uint32_t openBefore = FcsSimulator::openCryptoSessions;
+    CryptoSessionPool::setMaxSessions(1);
+    uint32_t sessionId = 0;
+    int32_t status = -1;
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(1, sessionId, status));
+    uint32_t otherSessionId = 0;
+    EXPECT_EQ(CryptoSessionPool::exhausted,
+        CryptoSessionPool::acquire(2, otherSessionId, status));
+    EXPECT_EQ(CryptoSessionPool::notLeased,
+        CryptoSessionPool::release(2, sessionId));
+    EXPECT_TRUE(CryptoSessionPool::hasLeases(1));
+
+    //closed session is replaced, not lent again with its state
+    CryptoSessionPool::releaseAll(1);
+    EXPECT_FALSE(CryptoSessionPool::hasLeases(1));
+    EXPECT_EQ(openBefore + 1, FcsSimulator::openCryptoSessions);
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(2, otherSessionId, status));
+    EXPECT_NE(sessionId, otherSessionId);
+
+    //lent sessions are closed as well
+    CryptoSessionPool::clear();
+    EXPECT_EQ(openBefore, FcsSimulator::openCryptoSessions);
+    CryptoSessionPool::setMaxSessions(0);
+}
+
+TEST(CryptoSessionPoolUT, leasesOfSameSlotInTwoReactorsAreKeptApart)
+{
+    ConnectionTable firstReactor;
+    ConnectionTable secondReactor;
+    firstReactor.setReactorIndex(0);
+    secondReactor.setReactorIndex(1);
+    firstReactor.setLimit(1);
+    secondReactor.setLimit(1);
+    Connection *first = firstReactor.allocate();
+    Connection *second = secondReactor.allocate();
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+
+    CryptoSessionPool::setMaxSessions(2);
+    uint32_t firstSessionId = 0;
+    uint32_t secondSessionId = 0;
+    int32_t status = -1;
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(first->token, firstSessionId, status));
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::acquire(second->token, secondSessionId, status));
+    EXPECT_EQ(CryptoSessionPool::notLeased,
+        CryptoSessionPool::release(first->token, secondSessionId));
+
+    //closing the connection in one reactor leaves the other's lease alone
+    CryptoSessionPool::releaseAll(first->token);
+    EXPECT_FALSE(CryptoSessionPool::hasLeases(first->token));
+    EXPECT_TRUE(CryptoSessionPool::hasLeases(second->token));
+    EXPECT_EQ(CryptoSessionPool::success,
+        CryptoSessionPool::release(second->token, secondSessionId));
+
+    CryptoSessionPool::clear();
+    CryptoSessionPool::setMaxSessions(0);
+}
+
+TEST(CryptoSessionPoolUT, handleIncomingMessage_openAndCloseSession)
+{
+    //open_crypto_session with id 1
+    std::vector<uint8_t> open {0xf1, 0x07, 0x00, 0x01};
+    ResponseMessage response;
+    handleIncomingMessage(open, response, 7);
+    std::vector<uint8_t> expectedOutput {0x03, 0x00, 0x00, 0x01};
+    EXPECT_EQ(expectedOutput, response.toVector());
+
+    CryptoSessionPool::setMaxSessions(1);
+    FcsSimulator::nextCryptoSessionId = 0x11223344;
+    response = ResponseMessage();
+    handleIncomingMessage(open, response, 7);
+    expectedOutput = {0x00, 0x10, 0x00, 0x01, 0x44, 0x33, 0x22, 0x11};
+    EXPECT_EQ(expectedOutput, response.toVector());
+
+    //close_crypto_session with id 2, from another connection and then its own
+    std::vector<uint8_t> close {
+        0xf2, 0x17, 0x00, 0x02, 0x44, 0x33, 0x22, 0x11};
+    response = ResponseMessage();
+    handleIncomingMessage(close, response, 8);
+    expectedOutput = {0x01, 0x00, 0x00, 0x02};
+    EXPECT_EQ(expectedOutput, response.toVector());
+    response = ResponseMessage();
+    handleIncomingMessage(close, response, 7);
+    expectedOutput = {0x00, 0x00, 0x00, 0x02};
+    EXPECT_EQ(expectedOutput, response.toVector());
+
+    CryptoSessionPool::clear();
+    CryptoSessionPool::setMaxSessions(0);
+}
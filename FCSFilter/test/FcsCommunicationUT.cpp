@@ -34,6 +34,9 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "FcsCommunication.h"
 #include "FcsSimulator.h"
+#include "Statistics.h"
+
+#include <algorithm>
 
 TEST(FcsCommunicationUT, intel_fcs_dev_ioctlSizeTest)
 {
@@ -50,6 +53,15 @@ TEST(FcsCommunicationUT, getChipIdTest)
     EXPECT_EQ(expectedPayload, payload);
 }
 
+TEST(FcsCommunicationUT, ioctlCountedOnCallingThread)
+{
+    //not cacheable, so it always reaches the device
+    uint64_t commandsBefore = Statistics::get(Statistics::deviceCommands);
+    int32_t status;
+    EXPECT_TRUE(FcsCommunication::sigmaTeardown(0xAAAA, status));
+    EXPECT_EQ(commandsBefore + 1, Statistics::get(Statistics::deviceCommands));
+}
+
 TEST(FcsCommunicationUT, sigmaTeardownTest)
 {
     FcsSimulator::expectedSessionId = 0xFFFFFFFF;
@@ -64,18 +76,36 @@ TEST(FcsCommunicationUT, createAttestationSubkeyTest)
 {
     FcsSimulator::expectedCreateSubkeyCommandLength = 1000;
     std::vector<uint8_t> payload(FcsSimulator::expectedCreateSubkeyCommandLength, 0x11);
-    std::vector<uint8_t> output;
+    ResponseBuffer output;
     int32_t status;
     EXPECT_TRUE(FcsCommunication::createAttestationSubkey(payload, output, status));
     EXPECT_EQ(0, status);
     EXPECT_EQ((size_t)ATTESTATION_SUBKEY_RSP_MAX_SZ, output.size());
 }
 
+TEST(FcsCommunicationUT, createAttestationSubkey_errorStatusDropsPayload)
+{
+    FcsSimulator::expectedCreateSubkeyCommandLength = 1000;
+    //a slab previously filled for another client goes back to the pool
+    {
+        ResponseBuffer previous = ResponseBuffer::fromPool();
+        previous.resize(ATTESTATION_SUBKEY_RSP_MAX_SZ);
+        std::fill(previous.data(), previous.data() + previous.size(), 0x5A);
+    }
+    //device rejects the command without touching the response
+    std::vector<uint8_t> payload(FcsSimulator::expectedCreateSubkeyCommandLength - 4, 0x11);
+    ResponseBuffer output;
+    int32_t status;
+    EXPECT_TRUE(FcsCommunication::createAttestationSubkey(payload, output, status));
+    EXPECT_NE(0, status);
+    EXPECT_EQ((size_t)0, output.size());
+}
+
 TEST(FcsCommunicationUT, getMeasurementTest)
 {
     FcsSimulator::expectedGetMeasurementCommandLength = 2000;
     std::vector<uint8_t> payload(FcsSimulator::expectedGetMeasurementCommandLength, 0x11);
-    std::vector<uint8_t> output;
+    ResponseBuffer output;
     int32_t status;
     EXPECT_TRUE(FcsCommunication::getMeasurement(payload, output, status));
     EXPECT_EQ(0, status);
@@ -85,7 +115,7 @@ TEST(FcsCommunicationUT, getMeasurementTest)
 TEST(FcsCommunicationUT, getAttestationCertificateTest)
 {
     FcsSimulator::expectedCertificateRequest = 0x03;
-    std::vector<uint8_t> output;
+    ResponseBuffer output;
     int32_t status;
     EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x03, output, status));
     EXPECT_EQ(0, status);
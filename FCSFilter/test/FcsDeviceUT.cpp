@@ -0,0 +1,114 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "FcsCommunication.h"
+#include "FcsDevice.h"
+#include "Statistics.h"
+
+#include <errno.h>
+
+class FcsDeviceUT : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            FcsDevice::closeIdle();
+            FcsDevice::setMaxOpenHandles(1);
+            Statistics::reset();
+        }
+        void TearDown() override
+        {
+            FcsDevice::setPath("/dev/fcs");
+            FcsDevice::closeIdle();
+        }
+};
+
+TEST_F(FcsDeviceUT, handleKeptOpenBetweenRequests)
+{
+    //chip ID would be cached, measurements always reach the device
+    std::vector<uint8_t> request;
+    ResponseBuffer payload;
+    int32_t status;
+    EXPECT_TRUE(FcsCommunication::getMeasurement(request, payload, status));
+    EXPECT_TRUE(FcsCommunication::getMeasurement(request, payload, status));
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::deviceOpens));
+}
+
+TEST_F(FcsDeviceUT, brokenHandleReopened)
+{
+    FcsDevice::Handle handle = FcsDevice::acquire();
+    EXPECT_TRUE(handle.pooled);
+    FcsDevice::release(handle, FcsDevice::isDeviceGone(ENODEV));
+    handle = FcsDevice::acquire();
+    FcsDevice::release(handle, FcsDevice::isDeviceGone(EINVAL));
+    handle = FcsDevice::acquire();
+    FcsDevice::release(handle, false);
+    EXPECT_EQ((uint64_t)2, Statistics::get(Statistics::deviceOpens));
+}
+
+TEST_F(FcsDeviceUT, concurrentCallersBeyondPool)
+{
+    FcsDevice::setMaxOpenHandles(2);
+    FcsDevice::Handle first = FcsDevice::acquire();
+    FcsDevice::Handle second = FcsDevice::acquire();
+    FcsDevice::Handle third = FcsDevice::acquire();
+    EXPECT_TRUE(first.pooled);
+    EXPECT_TRUE(second.pooled);
+    EXPECT_FALSE(third.pooled);
+    FcsDevice::release(third, false);
+    FcsDevice::release(second, false);
+    FcsDevice::release(first, false);
+
+    first = FcsDevice::acquire();
+    second = FcsDevice::acquire();
+    FcsDevice::release(second, false);
+    FcsDevice::release(first, false);
+    EXPECT_EQ((uint64_t)3, Statistics::get(Statistics::deviceOpens));
+}
+
+TEST_F(FcsDeviceUT, openFailure)
+{
+    FcsDevice::setPath("/dev/missing");
+    FcsDevice::Handle handle = FcsDevice::acquire();
+    EXPECT_EQ(-1, handle.fd);
+    EXPECT_FALSE(handle.pooled);
+    FcsDevice::release(handle, false);
+
+    //pool slot is free again once the device is back
+    FcsDevice::setPath("/dev/fcs");
+    handle = FcsDevice::acquire();
+    EXPECT_TRUE(handle.pooled);
+    FcsDevice::release(handle, false);
+}
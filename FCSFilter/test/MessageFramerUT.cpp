@@ -0,0 +1,216 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+#include "MessageFramer.h"
+
+TEST(MessageFramerUT, nextFrame_emptyBuffer)
+{
+    MessageFramer framer;
+    std::vector<uint8_t> frame;
+    EXPECT_FALSE(framer.nextFrame(frame));
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+}
+
+TEST(MessageFramerUT, nextFrame_singleFrame)
+{
+    //get_chipid - header only
+    std::vector<uint8_t> input {0x12, 0x00, 0x00, 0x10};
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    std::vector<uint8_t> frame;
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(input, frame);
+    EXPECT_FALSE(framer.nextFrame(frame));
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+}
+
+TEST(MessageFramerUT, nextFrame_coalescedFrames)
+{
+    //get_attestation_certificate followed by get_chipid in one read
+    std::vector<uint8_t> certificateRequest {0x81, 0x11, 0x00, 0x10, 0x01, 0x00, 0x00, 0x00};
+    std::vector<uint8_t> chipIdRequest {0x12, 0x00, 0x00, 0x10};
+    std::vector<uint8_t> input(certificateRequest);
+    input.insert(input.end(), chipIdRequest.begin(), chipIdRequest.end());
+
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    std::vector<uint8_t> frame;
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(certificateRequest, frame);
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(chipIdRequest, frame);
+    EXPECT_FALSE(framer.nextFrame(frame));
+}
+
+TEST(MessageFramerUT, nextFrame_splitFrame)
+{
+    //create_subkey with 2 words of data, delivered in 3 reads, split inside header and inside payload
+    std::vector<uint8_t> input {0x82, 0x21, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0xaa, 0xbb, 0xcc, 0xdd};
+    MessageFramer framer;
+    std::vector<uint8_t> frame;
+
+    framer.append(input.data(), 2);
+    EXPECT_FALSE(framer.nextFrame(frame));
+    framer.append(input.data() + 2, 7);
+    EXPECT_FALSE(framer.nextFrame(frame));
+    EXPECT_EQ((size_t)9, framer.getBufferedSize());
+    framer.append(input.data() + 9, input.size() - 9);
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(input, frame);
+}
+
+TEST(MessageFramerUT, getBufferedData_partialFrameAfterConsumedFrame)
+{
+    //get_chipid followed by the first 6 bytes of create_subkey
+    std::vector<uint8_t> input {0x12, 0x00, 0x00, 0x10, 0x82, 0x21, 0x00, 0x10, 0x00, 0x00};
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    std::vector<uint8_t> frame;
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_FALSE(framer.nextFrame(frame));
+    std::vector<uint8_t> expected(input.begin() + 4, input.end());
+    EXPECT_EQ(expected, framer.getBufferedData().toVector());
+}
+
+TEST(MessageFramerUT, nextFrame_largeFrameThroughWritePointer)
+{
+    //get_measurement with 1024 words (4096 bytes) of data received in chunks
+    const size_t payloadSize = 1024 * 4;
+    std::vector<uint8_t> input {0x83, 0x01, 0x40, 0x10};
+    input.resize(input.size() + payloadSize, 0x5A);
+    MessageFramer framer;
+    std::vector<uint8_t> frame;
+
+    const size_t chunkSize = 1500;
+    for (size_t offset = 0; offset < input.size(); offset += chunkSize)
+    {
+        EXPECT_FALSE(framer.nextFrame(frame));
+        size_t size = std::min(chunkSize, input.size() - offset);
+        uint8_t *destination = framer.getWritePointer(chunkSize);
+        std::copy(input.begin() + offset, input.begin() + offset + size, destination);
+        framer.commitWrite(size);
+    }
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(input, frame);
+    EXPECT_THROW(framer.commitWrite(chunkSize + 1), std::invalid_argument);
+}
+
+TEST(MessageFramerUT, reset)
+{
+    std::vector<uint8_t> input {0x82, 0x21, 0x00, 0x10, 0x00};
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    std::vector<uint8_t> frame;
+    EXPECT_FALSE(framer.nextFrame(frame));
+    framer.reset();
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+
+    std::vector<uint8_t> chipIdRequest {0x12, 0x00, 0x00, 0x10};
+    framer.append(chipIdRequest.data(), chipIdRequest.size());
+    EXPECT_TRUE(framer.nextFrame(frame));
+    EXPECT_EQ(chipIdRequest, frame);
+}
+
+TEST(MessageFramerUT, peekFrame_pointsIntoBufferUntilConsumed)
+{
+    std::vector<uint8_t> input {
+        0x82, 0x11, 0x00, 0x10, 0xaa, 0xbb, 0xcc, 0xdd,
+        0x12, 0x00, 0x00, 0x10};
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    BufferView frame;
+    EXPECT_TRUE(framer.peekFrame(frame));
+    EXPECT_EQ((size_t)8, frame.size());
+    const uint8_t *firstFrameData = frame.data();
+    EXPECT_TRUE(framer.peekFrame(frame));
+    EXPECT_EQ(firstFrameData, frame.data());
+    EXPECT_EQ(std::vector<uint8_t>(input.begin(), input.begin() + 8), frame.toVector());
+
+    framer.consumeFrame();
+    EXPECT_TRUE(framer.peekFrame(frame));
+    EXPECT_EQ(std::vector<uint8_t>(input.begin() + 8, input.end()), frame.toVector());
+    framer.consumeFrame();
+    EXPECT_FALSE(framer.peekFrame(frame));
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+}
+
+TEST(MessageFramerUT, detachBuffer_keepsFrameValid)
+{
+    std::vector<uint8_t> input {0x82, 0x11, 0x00, 0x10, 0xaa, 0xbb, 0xcc, 0xdd};
+    MessageFramer framer;
+    framer.append(input.data(), input.size());
+    BufferView frame;
+    EXPECT_TRUE(framer.peekFrame(frame));
+    std::vector<uint8_t> detached = framer.detachBuffer();
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+    EXPECT_EQ(detached.data(), frame.data());
+    EXPECT_EQ(input, frame.toVector());
+}
+
+TEST(MessageFramerUT, getWritePointer_queuedFramesNotMovedOnEveryWrite)
+{
+    //ten get_chipid requests with ids 0 to 9, as pipelined clients send them
+    std::vector<uint8_t> input;
+    for (uint8_t id = 0; id < 10; id++)
+    {
+        std::vector<uint8_t> chipIdRequest {0x12, 0x00, 0x00, id};
+        input.insert(input.end(), chipIdRequest.begin(), chipIdRequest.end());
+    }
+    MessageFramer framer;
+    //received into room for more, as the server reads
+    uint8_t *destination = framer.getWritePointer(64);
+    std::copy(input.begin(), input.end(), destination);
+    framer.commitWrite(input.size());
+    BufferView frame;
+    EXPECT_TRUE(framer.peekFrame(frame));
+    framer.consumeFrame();
+    EXPECT_TRUE(framer.peekFrame(frame));
+    const uint8_t *queuedFrame = frame.data();
+
+    std::vector<uint8_t> chipIdRequest {0x12, 0x00, 0x00, 0x0a};
+    framer.append(chipIdRequest.data(), chipIdRequest.size());
+    EXPECT_TRUE(framer.peekFrame(frame));
+    EXPECT_EQ(queuedFrame, frame.data());
+
+    for (uint8_t id = 1; id <= 10; id++)
+    {
+        EXPECT_TRUE(framer.peekFrame(frame));
+        EXPECT_EQ(id, frame[3]);
+        framer.consumeFrame();
+        framer.append(chipIdRequest.data(), 0);
+    }
+    EXPECT_EQ((size_t)0, framer.getBufferedSize());
+}
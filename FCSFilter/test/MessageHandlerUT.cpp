@@ -0,0 +1,132 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "gtest/gtest.h"
+#include <vector>
+
+#include "FcsSimulator.h"
+#include "MessageHandler.h"
+
+TEST(MessageHandlerUT, handleIncomingMessage_batch)
+{
+    //batch of get_chipid (id 1) and an unknown command (id 2)
+    std::vector<uint8_t> input {0xf0, 0x27, 0x00, 0x00, 0x12, 0x00, 0x00, 0x01, 0xff, 0x07, 0x00, 0x02};
+    std::vector<uint8_t> expectedOutput {
+        0x00, 0x40, 0x00, 0x00,
+        0x00, 0x20, 0x00, 0x01, 0x5A, 0xEC, 0xAC, 0x18, 0xCC, 0xC6, 0x82, 0x07,
+        0x03, 0x00, 0x00, 0x02};
+    ResponseMessage response;
+    handleIncomingMessage(input, response);
+    EXPECT_EQ(expectedOutput, response.toVector());
+}
+
+TEST(MessageHandlerUT, handleIncomingMessage_batchStopsBeforeResponseMightNotFit)
+{
+    //batch of six get_measurement requests (ids 1 to 6) with reserved word only
+    std::vector<uint8_t> input {0xf0, 0xc7, 0x00, 0x00};
+    for (uint8_t id = 1; id <= 6; id++)
+    {
+        std::vector<uint8_t> measurementRequest {0x83, 0x11, 0x00, id, 0x00, 0x00, 0x00, 0x00};
+        input.insert(input.end(), measurementRequest.begin(), measurementRequest.end());
+    }
+    uint32_t measurementRequests = FcsSimulator::measurementRequests;
+    ResponseMessage response;
+    handleIncomingMessage(input, response);
+
+    //room for the largest measurement is reserved, so the fifth is not run
+    EXPECT_EQ(measurementRequests + 4, FcsSimulator::measurementRequests);
+    size_t measurementResponseSize =
+        4 + FcsSimulator::expectedGetMeasurementResponseLength;
+    std::vector<uint8_t> output = response.toVector();
+    ASSERT_EQ(4 + 4 * measurementResponseSize + 4, output.size());
+    std::vector<uint8_t> lastResponse(output.end() - 4, output.end());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x05}), lastResponse);
+}
+
+TEST(MessageHandlerUT, handleIncomingMessage_batchAttestationSweep)
+{
+    //get_chipid (id 1), get_idcode (id 2), get_device_identity (id 3)
+    //and seven get_attestation_certificate requests (ids 4 to 10)
+    std::vector<uint8_t> input {0xf0, 0x17, 0x01, 0x00,
+        0x12, 0x00, 0x00, 0x01,
+        0x10, 0x00, 0x00, 0x02,
+        0x00, 0x05, 0x00, 0x03};
+    for (uint8_t id = 4; id <= 10; id++)
+    {
+        std::vector<uint8_t> certificateRequest {0x81, 0x11, 0x00, id, id, 0x00, 0x00, 0x00};
+        input.insert(input.end(), certificateRequest.begin(), certificateRequest.end());
+    }
+    ResponseMessage response;
+    handleIncomingMessage(input, response);
+
+    //six certificates fit next to the identity responses, the seventh
+    //is dropped once its actual response would overflow the frame
+    size_t identitySize = 12 + 4 + 4;
+    size_t certificateSize = 4 + FcsSimulator::expectedGetAttCertResponseLength;
+    std::vector<uint8_t> output = response.toVector();
+    ASSERT_EQ(4 + identitySize + 6 * certificateSize + 4, output.size());
+    size_t lastCertificate = 4 + identitySize + 5 * certificateSize;
+    std::vector<uint8_t> lastCertificateHeader(output.begin() + lastCertificate,
+        output.begin() + lastCertificate + 4);
+    EXPECT_EQ(std::vector<uint8_t>({0x00, 0x50, 0x14, 0x09}), lastCertificateHeader);
+    std::vector<uint8_t> lastResponse(output.end() - 4, output.end());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x0a}), lastResponse);
+}
+
+TEST(MessageHandlerUT, handleIncomingMessage_malformedBatch)
+{
+    std::vector<uint8_t> input {0xf0, 0x17, 0x00, 0x00, 0x12, 0x10, 0x00, 0x01};
+    std::vector<uint8_t> expectedOutput {0x04, 0x00, 0x00, 0x00};
+    ResponseMessage response;
+    handleIncomingMessage(input, response);
+    EXPECT_EQ(expectedOutput, response.toVector());
+}
+
+TEST(MessageHandlerUT, handleBusyMessage)
+{
+    //get_chipid with client 1 and id 2
+    std::vector<uint8_t> input {0x12, 0x00, 0x00, 0x12};
+    std::vector<uint8_t> expectedOutput {0x05, 0x00, 0x00, 0x12};
+    ResponseMessage response;
+    handleBusyMessage(input, response);
+    EXPECT_EQ(expectedOutput, response.toVector());
+}
+
+TEST(MessageHandlerUT, handleRetryLaterMessage)
+{
+    //get_chipid with client 1 and id 2
+    std::vector<uint8_t> input {0x12, 0x00, 0x00, 0x12};
+    std::vector<uint8_t> expectedOutput {0x06, 0x00, 0x00, 0x12};
+    ResponseMessage response;
+    handleRetryLaterMessage(input, response);
+    EXPECT_EQ(expectedOutput, response.toVector());
+}
@@ -0,0 +1,88 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "ResponseBuffer.h"
+#include "ResponseMessage.h"
+#include "Statistics.h"
+
+TEST(ResponseBufferUT, slabReturnsToPoolWithResponse)
+{
+    {
+        //warms the pool up, earlier tests may have left slabs in it
+        ResponseBuffer warmUp = ResponseBuffer::fromPool();
+    }
+    Statistics::reset();
+    for (int i = 0; i < 3; i++)
+    {
+        ResponseBuffer payload = ResponseBuffer::fromPool();
+        EXPECT_EQ((size_t)ResponseBuffer::kSlabSize, payload.size());
+        payload.resize(8);
+        ResponseMessage response;
+        response.setHeader(0x11223344);
+        response.setPayload(std::move(payload));
+        EXPECT_EQ((size_t)12, response.size());
+    }
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::responseBuffersAllocated));
+}
+
+TEST(ResponseBufferUT, resizeWithinSlabKeepsBytes)
+{
+    ResponseBuffer payload = ResponseBuffer::fromPool();
+    const uint8_t *slab = payload.data();
+    payload.data()[0] = 0x5A;
+    payload.data()[1] = 0xEC;
+    payload.resize(2);
+    payload.resize(100);
+    EXPECT_EQ(slab, payload.data());
+    EXPECT_EQ(0x5A, payload.data()[0]);
+    EXPECT_EQ(0xEC, payload.data()[1]);
+
+    payload.resize(ResponseBuffer::kSlabSize + 4);
+    EXPECT_EQ((size_t)(ResponseBuffer::kSlabSize + 4), payload.size());
+    EXPECT_EQ(0x5A, payload.data()[0]);
+}
+
+TEST(ResponseBufferUT, vectorWrappedWithoutCopy)
+{
+    std::vector<uint8_t> bytes {0x01, 0x02, 0x03, 0x04};
+    const uint8_t *data = bytes.data();
+    ResponseBuffer payload(std::move(bytes));
+    EXPECT_EQ(data, payload.data());
+    EXPECT_EQ((std::vector<uint8_t> {0x01, 0x02, 0x03, 0x04}), payload.toVector());
+
+    ResponseBuffer moved(std::move(payload));
+    EXPECT_EQ(data, moved.data());
+    EXPECT_TRUE(payload.empty());
+}
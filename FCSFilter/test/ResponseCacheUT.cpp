@@ -0,0 +1,202 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "FcsCommunication.h"
+#include "FcsSimulator.h"
+#include "ResponseCache.h"
+#include "Statistics.h"
+#include "VerifierProtocol.h"
+
+#include <future>
+
+class ResponseCacheUT : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            defaultPolicy = ResponseCache::getPolicy(getChipId);
+            ResponseCache::clear();
+            Statistics::reset();
+        }
+        void TearDown() override
+        {
+            ResponseCache::setPolicy(getChipId, defaultPolicy);
+            ResponseCache::clear();
+        }
+
+        ResponseCache::Policy defaultPolicy;
+};
+
+TEST_F(ResponseCacheUT, chipIdServedFromCache)
+{
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+    int32_t status = -1;
+    EXPECT_TRUE(FcsCommunication::getChipId(first, status));
+    status = -1;
+    EXPECT_TRUE(FcsCommunication::getChipId(second, status));
+    EXPECT_EQ(0, status);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheMisses));
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheHits));
+}
+
+TEST_F(ResponseCacheUT, certificateKeyedByRequest)
+{
+    FcsSimulator::expectedCertificateRequest = 0x03;
+    ResponseBuffer payload;
+    int32_t status;
+    EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x03, payload, status));
+    EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x03, payload, status));
+    EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x01, payload, status));
+    EXPECT_EQ((uint64_t)2, Statistics::get(Statistics::cacheMisses));
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheHits));
+}
+
+TEST_F(ResponseCacheUT, certificateReloadDropsOnlyCertificates)
+{
+    std::vector<uint8_t> payload;
+    ResponseBuffer certificate;
+    int32_t status;
+    EXPECT_TRUE(FcsCommunication::getChipId(payload, status));
+    EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x03, certificate, status));
+    ResponseCache::invalidate(ResponseCache::certificateReload);
+    EXPECT_TRUE(FcsCommunication::getChipId(payload, status));
+    EXPECT_TRUE(FcsCommunication::getAttestationCertificate(0x03, certificate, status));
+    EXPECT_EQ((uint64_t)3, Statistics::get(Statistics::cacheMisses));
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheHits));
+
+    ResponseCache::invalidate(ResponseCache::deviceReset);
+    EXPECT_TRUE(FcsCommunication::getChipId(payload, status));
+    EXPECT_EQ((uint64_t)4, Statistics::get(Statistics::cacheMisses));
+}
+
+TEST_F(ResponseCacheUT, responseFetchedAcrossInvalidationNotStored)
+{
+    std::vector<uint8_t> payload {0x01, 0x02};
+    int32_t status;
+    ResponseCache::Lookup lookup(getChipId, BufferView());
+    EXPECT_FALSE(lookup.hit(payload, status));
+    ResponseCache::invalidate(ResponseCache::deviceReset);
+    lookup.store(payload, 0);
+
+    ResponseCache::Lookup next(getChipId, BufferView());
+    EXPECT_FALSE(next.hit(payload, status));
+}
+
+TEST_F(ResponseCacheUT, errorStatusAndDisabledPolicyNotCached)
+{
+    std::vector<uint8_t> payload {0x01, 0x02};
+    int32_t status;
+    ResponseCache::Lookup failed(getChipId, BufferView());
+    failed.store(payload, -1);
+    ResponseCache::Lookup next(getChipId, BufferView());
+    EXPECT_FALSE(next.hit(payload, status));
+
+    ResponseCache::setPolicy(getChipId, { false, false, 0, 0 });
+    EXPECT_TRUE(FcsCommunication::getChipId(payload, status));
+    EXPECT_TRUE(FcsCommunication::getChipId(payload, status));
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::cacheHits));
+}
+
+TEST_F(ResponseCacheUT, uncachedCommandBypassesCache)
+{
+    std::vector<uint8_t> argument {0x01, 0x02, 0x03, 0x04};
+    std::vector<uint8_t> payload {0x05, 0x06};
+    int32_t status;
+    //a policy override cannot pull an uncached command into the cache
+    ResponseCache::setPolicy(mctp, { true, true, 0, 0 });
+    ResponseCache::Lookup first(mctp, argument);
+    EXPECT_FALSE(first.hit(payload, status));
+    first.store(payload, 0);
+    ResponseCache::Lookup second(mctp, argument);
+    EXPECT_FALSE(second.hit(payload, status));
+    EXPECT_FALSE(ResponseCache::getPolicy(mctp).cacheable);
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::cacheLookups));
+
+    ResponseCache::Lookup cached(getChipId, BufferView());
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheLookups));
+}
+
+TEST_F(ResponseCacheUT, concurrentIdenticalCallsShareResponse)
+{
+    ResponseCache::setPolicy(getChipId, { false, true, 0, 0 });
+    std::vector<uint8_t> payload {0x01, 0x02};
+    int32_t status;
+    ResponseCache::Lookup leader(getChipId, BufferView());
+    EXPECT_FALSE(leader.hit(payload, status));
+
+    std::vector<uint8_t> sharedPayload;
+    int32_t sharedStatus = -1;
+    std::future<bool> follower = std::async(std::launch::async, [&]
+    {
+        ResponseCache::Lookup lookup(getChipId, BufferView());
+        return lookup.hit(sharedPayload, sharedStatus);
+    });
+    EXPECT_EQ(std::future_status::timeout,
+        follower.wait_for(std::chrono::milliseconds(50)));
+    leader.store(payload, 0);
+    EXPECT_TRUE(follower.get());
+    EXPECT_EQ(payload, sharedPayload);
+    EXPECT_EQ(0, sharedStatus);
+    EXPECT_EQ((uint64_t)1, Statistics::get(Statistics::cacheCoalesced));
+
+    //not cached, so the flight is over
+    ResponseCache::Lookup next(getChipId, BufferView());
+    EXPECT_FALSE(next.hit(payload, status));
+}
+
+TEST_F(ResponseCacheUT, failedFlightLetsWaiterCallDevice)
+{
+    ResponseCache::setPolicy(getChipId, { false, true, 0, 0 });
+    std::vector<uint8_t> payload;
+    int32_t status;
+    std::future<bool> follower;
+    {
+        ResponseCache::Lookup leader(getChipId, BufferView());
+        EXPECT_FALSE(leader.hit(payload, status));
+        follower = std::async(std::launch::async, []
+        {
+            std::vector<uint8_t> followerPayload;
+            int32_t followerStatus;
+            ResponseCache::Lookup lookup(getChipId, BufferView());
+            return lookup.hit(followerPayload, followerStatus);
+        });
+        EXPECT_EQ(std::future_status::timeout,
+            follower.wait_for(std::chrono::milliseconds(50)));
+    }
+    EXPECT_FALSE(follower.get());
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::cacheCoalesced));
+}
@@ -0,0 +1,83 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "gtest/gtest.h"
+#include <vector>
+
+#include "ResponseMessage.h"
+
+TEST(ResponseMessageUT, empty)
+{
+    ResponseMessage response;
+    EXPECT_TRUE(response.empty());
+    EXPECT_EQ((size_t)0, response.size());
+    iovec iovecs[ResponseMessage::kMaxIovecs];
+    EXPECT_EQ((size_t)0, response.getIovecs(0, iovecs));
+}
+
+TEST(ResponseMessageUT, getIovecs_headerAndPayload)
+{
+    ResponseMessage response;
+    response.setHeader(0x10002000);
+    std::vector<uint8_t> payload {0x11, 0x22, 0x33, 0x44, 0xAA, 0xBB, 0xCC, 0xDD};
+    const uint8_t *payloadData = payload.data();
+    response.setPayload(std::move(payload));
+    EXPECT_FALSE(response.empty());
+    EXPECT_EQ((size_t)12, response.size());
+    std::vector<uint8_t> expectedOutput {0x00, 0x20, 0x00, 0x10, 0x11, 0x22, 0x33, 0x44, 0xAA, 0xBB, 0xCC, 0xDD};
+    EXPECT_EQ(expectedOutput, response.toVector());
+
+    iovec iovecs[ResponseMessage::kMaxIovecs];
+    EXPECT_EQ((size_t)2, response.getIovecs(0, iovecs));
+    EXPECT_EQ((size_t)4, iovecs[0].iov_len);
+    //payload is not copied
+    EXPECT_EQ(payloadData, iovecs[1].iov_base);
+    EXPECT_EQ((size_t)8, iovecs[1].iov_len);
+}
+
+TEST(ResponseMessageUT, getIovecs_partiallySent)
+{
+    ResponseMessage response;
+    response.setHeader(0x10002000);
+    response.setPayload(std::vector<uint8_t> {0x11, 0x22, 0x33, 0x44});
+    iovec iovecs[ResponseMessage::kMaxIovecs];
+
+    EXPECT_EQ((size_t)2, response.getIovecs(3, iovecs));
+    EXPECT_EQ((size_t)1, iovecs[0].iov_len);
+    EXPECT_EQ((uint8_t)0x10, *(uint8_t*)iovecs[0].iov_base);
+
+    EXPECT_EQ((size_t)1, response.getIovecs(6, iovecs));
+    EXPECT_EQ((size_t)2, iovecs[0].iov_len);
+    EXPECT_EQ((uint8_t)0x33, *(uint8_t*)iovecs[0].iov_base);
+
+    EXPECT_EQ((size_t)0, response.getIovecs(8, iovecs));
+}
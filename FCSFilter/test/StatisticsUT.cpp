@@ -0,0 +1,80 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "gtest/gtest.h"
+
+#include "Statistics.h"
+
+TEST(StatisticsUT, incrementAndDecrement)
+{
+    Statistics::reset();
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::serverConnections));
+    Statistics::increment(Statistics::serverConnections);
+    Statistics::increment(Statistics::serverConnections, 4);
+    EXPECT_EQ((uint64_t)5, Statistics::get(Statistics::serverConnections));
+    Statistics::decrement(Statistics::serverConnections, 2);
+    EXPECT_EQ((uint64_t)3, Statistics::get(Statistics::serverConnections));
+
+    //gauge never goes below zero
+    Statistics::decrement(Statistics::serverConnections, 10);
+    EXPECT_EQ((uint64_t)0, Statistics::get(Statistics::serverConnections));
+}
+
+TEST(StatisticsUT, setAndSetMax)
+{
+    Statistics::reset();
+    Statistics::set(Statistics::executorQueueDepth, 7);
+    EXPECT_EQ((uint64_t)7, Statistics::get(Statistics::executorQueueDepth));
+    Statistics::setMax(Statistics::executorQueueDepthMax, 10);
+    Statistics::setMax(Statistics::executorQueueDepthMax, 3);
+    EXPECT_EQ((uint64_t)10, Statistics::get(Statistics::executorQueueDepthMax));
+    Statistics::setMax(Statistics::executorQueueDepthMax, 12);
+    EXPECT_EQ((uint64_t)12, Statistics::get(Statistics::executorQueueDepthMax));
+}
+
+TEST(StatisticsUT, toString)
+{
+    Statistics::reset();
+    EXPECT_EQ("", Statistics::toString());
+    Statistics::increment(Statistics::serverConnections, 2);
+    Statistics::increment(Statistics::cacheHits);
+    EXPECT_EQ("cache.hits=1 server.connections=2", Statistics::toString());
+}
+
+TEST(StatisticsUT, getName_sortedByName)
+{
+    for (uint32_t counter = 1; counter < Statistics::counterCount; counter++)
+    {
+        EXPECT_LT(std::string(Statistics::getName(Statistics::Counter(counter - 1))),
+            std::string(Statistics::getName(Statistics::Counter(counter))));
+    }
+}
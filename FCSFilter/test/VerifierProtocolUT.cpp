@@ -115,7 +115,9 @@ TEST(VerifierProtocolUT, parseMessage_createSubkey)
     EXPECT_THROW(verifierProtocol.getCertificateRequest(), std::logic_error);
     EXPECT_THROW(verifierProtocol.getSigmaTeardownSessionId(), std::logic_error);
     std::vector<uint8_t> expectedPayload{0xaa, 0xbb, 0xcc, 0xdd};
-    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload());
+    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload().toVector());
+    //payload is not copied out of the message
+    EXPECT_EQ(input.data() + 8, verifierProtocol.getIncomingPayload().data());
 }
 
 TEST(VerifierProtocolUT, parseMessage_getMeasurement)
@@ -127,7 +129,7 @@ TEST(VerifierProtocolUT, parseMessage_getMeasurement)
     EXPECT_THROW(verifierProtocol.getCertificateRequest(), std::logic_error);
     EXPECT_THROW(verifierProtocol.getSigmaTeardownSessionId(), std::logic_error);
     std::vector<uint8_t> expectedPayload{0xaa, 0xbb, 0xcc, 0xdd};
-    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload());
+    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload().toVector());
 }
 
 TEST(VerifierProtocolUT, parseMessage_getCertificate)
@@ -201,6 +203,71 @@ TEST(VerifierProtocolUT, prepareResponseMessage_withPayload)
     EXPECT_EQ(expectedOutput, output);
 }
 
+TEST(VerifierProtocolUT, prepareResponseMessage_movesPayloadIntoResponse)
+{
+    std::vector<uint8_t> incommingMessage {0x12, 0x00, 0x00, 0x10};
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.parseMessage(incommingMessage);
+
+    std::vector<uint8_t> expectedOutput {0x00, 0x20, 0x00, 0x10, 0x11, 0x22, 0x33, 0x44, 0xAA, 0xBB, 0xCC, 0xDD};
+    ResponseMessage response;
+    std::vector<uint8_t> payload {0x11, 0x22, 0x33, 0x44, 0xAA, 0xBB, 0xCC, 0xDD};
+    const uint8_t *payloadData = payload.data();
+    verifierProtocol.prepareResponseMessage(std::move(payload), response, noError);
+    EXPECT_EQ(expectedOutput, response.toVector());
+    EXPECT_EQ(payloadData, response.getPayload().data());
+}
+
+TEST(VerifierProtocolUT, prepareResponseMessage_responseMessageNotDivisibleByWordSize)
+{
+    std::vector<uint8_t> incommingMessage {0x12, 0x00, 0x00, 0x10};
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.parseMessage(incommingMessage);
+
+    std::vector<uint8_t> expectedOutput {0x01, 0x00, 0x00, 0x10};
+    ResponseMessage response;
+    verifierProtocol.prepareResponseMessage(
+        std::vector<uint8_t> {0xAA, 0xBB, 0xCC}, response, noError);
+    EXPECT_EQ(expectedOutput, response.toVector());
+}
+
+TEST(VerifierProtocolUT, getBatchedRequests)
+{
+    //batch of get_chipid and get_certificate
+    std::vector<uint8_t> input {0xf0, 0x37, 0x00, 0x00, 0x12, 0x00, 0x00, 0x01, 0x81, 0x11, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00};
+    VerifierProtocol verifierProtocol;
+    EXPECT_TRUE(verifierProtocol.parseMessage(input));
+    EXPECT_EQ(batchRequest, verifierProtocol.getCommandCode());
+    EXPECT_THROW(verifierProtocol.getCertificateRequest(), std::logic_error);
+
+    std::vector<BufferView> requests;
+    EXPECT_TRUE(verifierProtocol.getBatchedRequests(requests));
+    EXPECT_EQ((size_t)2, requests.size());
+    EXPECT_EQ(std::vector<uint8_t>(input.begin() + 4, input.begin() + 8), requests[0].toVector());
+    EXPECT_EQ(std::vector<uint8_t>(input.begin() + 8, input.end()), requests[1].toVector());
+}
+
+TEST(VerifierProtocolUT, getBatchedRequests_requestExceedsBatch)
+{
+    //get_certificate header says one word, none follows
+    std::vector<uint8_t> input {0xf0, 0x27, 0x00, 0x00, 0x12, 0x00, 0x00, 0x01, 0x81, 0x11, 0x00, 0x02};
+    VerifierProtocol verifierProtocol;
+    EXPECT_TRUE(verifierProtocol.parseMessage(input));
+    std::vector<BufferView> requests;
+    EXPECT_FALSE(verifierProtocol.getBatchedRequests(requests));
+    EXPECT_EQ(invalidHeader, verifierProtocol.getErrorCode());
+}
+
+TEST(VerifierProtocolUT, getBatchedRequests_nestedBatch)
+{
+    std::vector<uint8_t> input {0xf0, 0x17, 0x00, 0x00, 0xf0, 0x07, 0x00, 0x00};
+    VerifierProtocol verifierProtocol;
+    EXPECT_TRUE(verifierProtocol.parseMessage(input));
+    std::vector<BufferView> requests;
+    EXPECT_FALSE(verifierProtocol.getBatchedRequests(requests));
+    EXPECT_EQ(invalidHeader, verifierProtocol.getErrorCode());
+}
+
 TEST(VerifierProtocolUT, parseMessage_mctp)
 {
     std::vector<uint8_t> input {0x94, 0x21, 0x00, 0x10, 0x11, 0x22, 0x33, 0x44, 0xAA, 0xBB, 0xCC, 0xDD};
@@ -212,7 +279,7 @@ TEST(VerifierProtocolUT, parseMessage_mctp)
     EXPECT_EQ(mctp, verifierProtocol.getCommandCode());
     EXPECT_THROW(verifierProtocol.getCertificateRequest(), std::logic_error);
     EXPECT_THROW(verifierProtocol.getSigmaTeardownSessionId(), std::logic_error);
-    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload());
+    EXPECT_EQ(expectedPayload, verifierProtocol.getIncomingPayload().toVector());
 }
 
 TEST(VerifierProtocolUT, parseMessage_getIdCode)
@@ -38,3 +38,6 @@ uint32_t FcsSimulator::expectedGetMeasurementCommandLength = 0;
 uint32_t FcsSimulator::expectedGetMeasurementResponseLength = 1200;
 uint32_t FcsSimulator::expectedCertificateRequest = 0;
 uint32_t FcsSimulator::expectedGetAttCertResponseLength = 1300;
+uint32_t FcsSimulator::nextCryptoSessionId = 1;
+uint32_t FcsSimulator::openCryptoSessions = 0;
+uint32_t FcsSimulator::measurementRequests = 0;
@@ -41,4 +41,7 @@ class FcsSimulator
         static uint32_t expectedGetMeasurementResponseLength;
         static uint32_t expectedCertificateRequest;
         static uint32_t expectedGetAttCertResponseLength;
+        static uint32_t nextCryptoSessionId;
+        static uint32_t openCryptoSessions;
+        static uint32_t measurementRequests;
 };
@@ -73,6 +73,17 @@ int ioctl(int fileDescriptor, unsigned long int commandCode, intel_fcs_dev_ioctl
             }
         }
         break;
+        case (INTEL_FCS_DEV_CRYPTO_OPEN_SESSION_CMD): {
+            data->com_paras.s_session.sid = FcsSimulator::nextCryptoSessionId++;
+            FcsSimulator::openCryptoSessions++;
+            data->status = 0;
+        }
+        break;
+        case (INTEL_FCS_DEV_CRYPTO_CLOSE_SESSION_CMD): {
+            FcsSimulator::openCryptoSessions--;
+            data->status = 0;
+        }
+        break;
         case (INTEL_FCS_DEV_ATTESTATION_SUBKEY_CMD): {
             if (data->com_paras.subkey.rsp_data_sz < ATTESTATION_SUBKEY_RSP_MAX_SZ) {
                 errno = EINVAL;
@@ -89,6 +100,7 @@ int ioctl(int fileDescriptor, unsigned long int commandCode, intel_fcs_dev_ioctl
         }
         break;
         case (INTEL_FCS_DEV_ATTESTATION_MEASUREMENT_CMD): {
+            FcsSimulator::measurementRequests++;
             if (data->com_paras.measurement.rsp_data_sz < ATTESTATION_MEASUREMENT_RSP_MAX_SZ) {
                 errno = EINVAL;
                 return -1;
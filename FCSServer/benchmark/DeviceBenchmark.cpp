@@ -0,0 +1,152 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+/*
+Compares the per-request device cost:
+- open per request: open, ioctl and close around every request, as before
+- kept handle: ioctl on a descriptor taken from FcsDevice and given back
+/dev/fcs is not available off the board, so /dev/null stands in for it.
+The ioctl fails right away there, which leaves the open and close cost
+the driver adds around each request, plus the pool's own locking.
+*/
+
+#include "FcsDevice.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const uint32_t kIterations = 200000;
+static const char *kDevicePath = "/dev/null";
+
+static bool openPerRequest()
+{
+    int fd = open(kDevicePath, O_RDWR);
+    if (fd < 0)
+    {
+        return false;
+    }
+    int unused;
+    ioctl(fd, FIONREAD, &unused);
+    close(fd);
+    return true;
+}
+
+static bool keptHandle()
+{
+    FcsDevice::Handle device = FcsDevice::acquire();
+    if (device.fd < 0)
+    {
+        return false;
+    }
+    int unused;
+    bool failed = ioctl(device.fd, FIONREAD, &unused) < 0;
+    FcsDevice::release(device, failed && FcsDevice::isDeviceGone(errno));
+    return true;
+}
+
+// Returns nanoseconds per request and thread, negative on failure
+static double measure(bool (*request)(), uint32_t threadCount)
+{
+    std::vector<std::thread> threads;
+    std::vector<bool> succeeded(threadCount, true);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (uint32_t i = 0; i < kIterations; i++)
+            {
+                if (!request())
+                {
+                    succeeded[t] = false;
+                    return;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    for (bool threadSucceeded : succeeded)
+    {
+        if (!threadSucceeded)
+        {
+            return -1;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / kIterations;
+}
+
+static void printResult(const char *path, uint32_t threadCount,
+    double nanosecondsPerRequest)
+{
+    std::cout << std::setw(18) << path << std::setw(10) << threadCount;
+    if (nanosecondsPerRequest < 0)
+    {
+        std::cout << "  failed: " << strerror(errno) << std::endl;
+        return;
+    }
+    std::cout << std::setw(14) << std::fixed << std::setprecision(1)
+              << nanosecondsPerRequest << std::endl;
+}
+
+int main()
+{
+    Logger::setCurrentLogLevel(Error);
+    FcsDevice::setPath(kDevicePath);
+
+    std::cout << std::setw(18) << "path"
+              << std::setw(10) << "threads"
+              << std::setw(14) << "ns/request" << std::endl;
+    for (uint32_t threadCount : {1u, 4u})
+    {
+        FcsDevice::setMaxOpenHandles(threadCount);
+        printResult("open per request", threadCount,
+            measure(openPerRequest, threadCount));
+        printResult("kept handle", threadCount,
+            measure(keptHandle, threadCount));
+    }
+    FcsDevice::closeIdle();
+    return 0;
+}
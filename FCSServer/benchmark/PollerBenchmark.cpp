@@ -0,0 +1,295 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+/*
+Compares poller backends in two loopback scenarios:
+- per-event cost while the number of idle connections registered in the
+  poller grows. One active socket pair is pinged repeatedly, all other
+  registered sockets never become ready.
+- connection churn over TCP loopback: accept, register, receive one request,
+  unregister and close, as the server does for a short lived verifier.
+  Reports system calls made by the poller itself, where io_uring submits
+  registration changes with its wait call. Socket calls are the same for
+  every backend and are not counted.
+*/
+
+#include "Logger.h"
+#include "Poller.h"
+
+#include <chrono>
+#include <errno.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const uint32_t kIterations = 20000;
+static const uint32_t kIdleConnectionCounts[] = { 0, 10, 100, 1000, 5000 };
+// kept below the ephemeral port range even though clients reset connections
+static const uint32_t kChurnIterations = 5000;
+static const PollerBackend kBackends[] =
+    { pollBackend, epollBackend, ioUringBackend };
+
+struct ChurnResult
+{
+    double nanosecondsPerConnection = -1;
+    double systemCallsPerConnection = 0;
+};
+
+struct SocketPair
+{
+    int local = -1;
+    int remote = -1;
+};
+
+static bool openSocketPair(SocketPair &pair)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1)
+    {
+        return false;
+    }
+    pair.local = fds[0];
+    pair.remote = fds[1];
+    return true;
+}
+
+static void closeSocketPair(SocketPair &pair)
+{
+    close(pair.local);
+    close(pair.remote);
+}
+
+static void raiseFileDescriptorLimit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Returns average nanoseconds per wakeup, or -1 when setup failed
+static double measure(PollerBackend backend, uint32_t idleConnections)
+{
+    std::unique_ptr<Poller> poller = Poller::create(backend);
+    std::vector<SocketPair> idlePairs(idleConnections);
+    double result = -1;
+    size_t opened = 0;
+    for (; opened < idlePairs.size(); opened++)
+    {
+        if (!openSocketPair(idlePairs[opened])
+            || !poller->add(idlePairs[opened].local,
+                readableEvent | edgeTriggeredEvent, opened + 1))
+        {
+            break;
+        }
+    }
+
+    SocketPair active;
+    if (opened == idlePairs.size() && openSocketPair(active))
+    {
+        poller->add(active.local, readableEvent | edgeTriggeredEvent, 0);
+        std::vector<PollerEvent> readyEvents;
+        uint8_t byte = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < kIterations; i++)
+        {
+            if (write(active.remote, &byte, sizeof(byte)) != sizeof(byte)
+                || poller->wait(readyEvents, -1) != 1
+                || read(active.local, &byte, sizeof(byte)) != sizeof(byte))
+            {
+                break;
+            }
+            if (i + 1 == kIterations)
+            {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                result = std::chrono::duration<double, std::nano>(
+                    elapsed).count() / kIterations;
+            }
+        }
+        closeSocketPair(active);
+    }
+
+    for (size_t i = 0; i < opened; i++)
+    {
+        closeSocketPair(idlePairs[i]);
+    }
+    return result;
+}
+
+static int openLoopbackListener(sockaddr_in &address)
+{
+    int listenerFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listenerFd == -1)
+    {
+        return -1;
+    }
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressSize = sizeof(address);
+    if (bind(listenerFd, (sockaddr*)&address, sizeof(address)) == -1
+        || listen(listenerFd, SOMAXCONN) == -1
+        || getsockname(listenerFd, (sockaddr*)&address, &addressSize) == -1)
+    {
+        close(listenerFd);
+        return -1;
+    }
+    return listenerFd;
+}
+
+// Closes with RST, so benchmark does not fill the port range with TIME_WAIT
+static void resetAndClose(int fd)
+{
+    linger lingerOption = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lingerOption, sizeof(lingerOption));
+    close(fd);
+}
+
+static bool serveOneConnection(
+    Poller &poller, int listenerFd, const sockaddr_in &address)
+{
+    std::vector<PollerEvent> readyEvents;
+    int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (clientFd == -1)
+    {
+        return false;
+    }
+    bool served = false;
+    int serverFd = -1;
+    uint8_t byte = 0;
+    if (connect(clientFd, (const sockaddr*)&address, sizeof(address)) == 0
+        && poller.wait(readyEvents, -1) >= 1)
+    {
+        serverFd = accept4(listenerFd, nullptr, nullptr, SOCK_NONBLOCK);
+    }
+    if (serverFd != -1)
+    {
+        served = poller.add(serverFd, readableEvent | edgeTriggeredEvent, 1)
+            && write(clientFd, &byte, sizeof(byte)) == sizeof(byte)
+            && poller.wait(readyEvents, -1) == 1
+            && read(serverFd, &byte, sizeof(byte)) == sizeof(byte);
+        poller.remove(serverFd);
+        close(serverFd);
+    }
+    resetAndClose(clientFd);
+    return served;
+}
+
+static ChurnResult measureChurn(PollerBackend backend)
+{
+    ChurnResult result;
+    std::unique_ptr<Poller> poller = Poller::create(backend);
+    sockaddr_in address;
+    int listenerFd = openLoopbackListener(address);
+    if (listenerFd == -1 || !poller->add(listenerFd, readableEvent, 0))
+    {
+        return result;
+    }
+    uint64_t systemCallsAtStart = poller->getSystemCallCount();
+    auto start = std::chrono::steady_clock::now();
+    uint32_t i = 0;
+    for (; i < kChurnIterations; i++)
+    {
+        if (!serveOneConnection(*poller, listenerFd, address))
+        {
+            break;
+        }
+    }
+    if (i == kChurnIterations)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        result.nanosecondsPerConnection = std::chrono::duration<double,
+            std::nano>(elapsed).count() / kChurnIterations;
+        result.systemCallsPerConnection = double(
+            poller->getSystemCallCount() - systemCallsAtStart)
+            / kChurnIterations;
+    }
+    poller->remove(listenerFd);
+    close(listenerFd);
+    return result;
+}
+
+int main()
+{
+    Logger::setCurrentLogLevel(Error);
+    raiseFileDescriptorLimit();
+
+    std::cout << std::setw(18) << "idle connections";
+    for (PollerBackend backend : kBackends)
+    {
+        std::cout << std::setw(12) << Poller::create(backend)->getName()
+                  << " [ns/evt]";
+    }
+    std::cout << std::endl;
+    for (uint32_t idleConnections : kIdleConnectionCounts)
+    {
+        std::cout << std::setw(18) << idleConnections;
+        for (PollerBackend backend : kBackends)
+        {
+            double result = measure(backend, idleConnections);
+            if (result < 0)
+            {
+                std::cout << "  skipped: " << strerror(errno);
+                break;
+            }
+            std::cout << std::setw(21) << std::fixed << std::setprecision(0)
+                      << result;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << std::endl << std::setw(18) << "loopback churn"
+              << std::setw(16) << "[ns/conn]"
+              << std::setw(24) << "[poller syscalls/conn]" << std::endl;
+    for (PollerBackend backend : kBackends)
+    {
+        std::unique_ptr<Poller> poller = Poller::create(backend);
+        ChurnResult result = measureChurn(backend);
+        std::cout << std::setw(18) << poller->getName();
+        if (result.nanosecondsPerConnection < 0)
+        {
+            std::cout << "  skipped: " << strerror(errno) << std::endl;
+            continue;
+        }
+        std::cout << std::setw(16) << std::fixed << std::setprecision(0)
+                  << result.nanosecondsPerConnection
+                  << std::setw(24) << std::setprecision(2)
+                  << result.systemCallsPerConnection << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+/*
+Compares the two ways of sending a 4096 byte certificate response:
+- copy: payload is appended behind the header into one buffer, then sent
+- gather: header and payload stay apart and go out with one sendmsg
+Each response starts from a freshly filled payload, as returned by the ioctl.
+Responses are written to a unix socket pair drained by a second thread.
+Also compares the buffer an ioctl writes its response into:
+- vector: allocated and zero filled to the maximum size, then shrunk
+- pool: ResponseBuffer slab taken from the pool, returned with the response
+*/
+
+#include "Logger.h"
+#include "ResponseBuffer.h"
+#include "VerifierProtocol.h"
+#include "intel_fcs_structs.h"
+
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+static const uint32_t kIterations = 200000;
+static const size_t kPayloadSizeInBytes = 4096;
+
+static bool sendAll(int fd, const std::vector<uint8_t> &buffer)
+{
+    size_t sent = 0;
+    while (sent < buffer.size())
+    {
+        ssize_t size = send(fd, buffer.data() + sent, buffer.size() - sent, 0);
+        if (size <= 0)
+        {
+            return false;
+        }
+        sent += size;
+    }
+    return true;
+}
+
+static bool sendAll(int fd, const ResponseMessage &response)
+{
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        iovec iovecs[ResponseMessage::kMaxIovecs];
+        msghdr message = {};
+        message.msg_iov = iovecs;
+        message.msg_iovlen = response.getIovecs(sent, iovecs);
+        ssize_t size = sendmsg(fd, &message, 0);
+        if (size <= 0)
+        {
+            return false;
+        }
+        sent += size;
+    }
+    return true;
+}
+
+// what the ioctl does with a certificate that is shorter than the maximum
+static const size_t kCertificateSizeInBytes = 1500;
+
+static void drain(int fd)
+{
+    std::vector<uint8_t> buffer(64 * 1024);
+    while (recv(fd, buffer.data(), buffer.size(), 0) > 0)
+    {
+    }
+}
+
+// Returns nanoseconds per response, negative on failure
+template <typename PrepareAndSend>
+static double measure(PrepareAndSend prepareAndSend)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kIterations; i++)
+    {
+        std::vector<uint8_t> payload(kPayloadSizeInBytes, static_cast<uint8_t>(i));
+        if (!prepareAndSend(std::move(payload)))
+        {
+            return -1;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / kIterations;
+}
+
+static void printResult(const char *path, const char *scenario,
+    double nanosecondsPerResponse)
+{
+    std::cout << std::setw(10) << path << std::setw(14) << scenario;
+    if (nanosecondsPerResponse < 0)
+    {
+        std::cout << "  failed: " << strerror(errno) << std::endl;
+        return;
+    }
+    std::cout << std::setw(16) << std::fixed << std::setprecision(1)
+              << nanosecondsPerResponse << std::endl;
+}
+
+int main()
+{
+    Logger::setCurrentLogLevel(Error);
+    std::vector<uint8_t> request {0x81, 0x11, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00};
+    VerifierProtocol verifierProtocol;
+    verifierProtocol.parseMessage(request);
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+    {
+        std::cout << "Socket pair failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::thread drainer(drain, fds[1]);
+
+    std::cout << std::setw(10) << "path"
+              << std::setw(14) << "scenario"
+              << std::setw(16) << "ns/response" << std::endl;
+    printResult("copy", "prepare", measure(
+        [&](std::vector<uint8_t> &&payload)
+        {
+            std::vector<uint8_t> responseBuffer;
+            verifierProtocol.prepareResponseMessage(
+                payload, responseBuffer, noError);
+            return responseBuffer.size() > kPayloadSizeInBytes;
+        }));
+    printResult("gather", "prepare", measure(
+        [&](std::vector<uint8_t> &&payload)
+        {
+            ResponseMessage response;
+            verifierProtocol.prepareResponseMessage(
+                std::move(payload), response, noError);
+            return response.size() > kPayloadSizeInBytes;
+        }));
+    printResult("copy", "prepare+send", measure(
+        [&](std::vector<uint8_t> &&payload)
+        {
+            std::vector<uint8_t> responseBuffer;
+            verifierProtocol.prepareResponseMessage(
+                payload, responseBuffer, noError);
+            return sendAll(fds[0], responseBuffer);
+        }));
+    printResult("gather", "prepare+send", measure(
+        [&](std::vector<uint8_t> &&payload)
+        {
+            ResponseMessage response;
+            verifierProtocol.prepareResponseMessage(
+                std::move(payload), response, noError);
+            return sendAll(fds[0], response);
+        }));
+
+    printResult("vector", "acquire", measure(
+        [&](std::vector<uint8_t> &&)
+        {
+            std::vector<uint8_t> payload;
+            payload.resize(ATTESTATION_CERTIFICATE_RSP_MAX_SZ);
+            memset(payload.data(), 0x7e, kCertificateSizeInBytes);
+            payload.resize(kCertificateSizeInBytes);
+            ResponseMessage response;
+            verifierProtocol.prepareResponseMessage(
+                std::move(payload), response, noError);
+            return response.size() > kCertificateSizeInBytes;
+        }));
+    printResult("pool", "acquire", measure(
+        [&](std::vector<uint8_t> &&)
+        {
+            ResponseBuffer payload = ResponseBuffer::fromPool();
+            payload.resize(ATTESTATION_CERTIFICATE_RSP_MAX_SZ);
+            memset(payload.data(), 0x7e, kCertificateSizeInBytes);
+            payload.resize(kCertificateSizeInBytes);
+            ResponseMessage response;
+            verifierProtocol.prepareResponseMessage(
+                std::move(payload), response, noError);
+            return response.size() > kCertificateSizeInBytes;
+        }));
+
+    shutdown(fds[0], SHUT_WR);
+    drainer.join();
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
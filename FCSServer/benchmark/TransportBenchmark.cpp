@@ -0,0 +1,222 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+/*
+Compares request round trip latency of local clients connecting over TCP
+loopback and over the unix domain socket. Server runs in process with an
+echo handler, so the numbers cover transport and event loop only.
+*/
+
+#include "CommandHeader.h"
+#include "Logger.h"
+#include "ServerConfig.h"
+#include "TcpServer.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <errno.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+static const uint32_t kPortNumber = 50991;
+static const char kUnixSocketPath[] = "/tmp/fcsServerBenchmark.sock";
+static const uint32_t kIterations = 20000;
+// command header only, then a payload of the size of a certificate
+static const uint16_t kPayloadWords[] = { 0, 256 };
+
+static void echo(BufferView message, ResponseMessage &response, uint64_t)
+{
+    response.setHeader(Utils::decodeFromLittleEndianBuffer(message));
+    response.setPayload(
+        message.subview(CommandHeader::getRequiredSize()).toVector());
+}
+
+static int connectTcp()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(kPortNumber);
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int connectUnix()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, kUnixSocketPath, sizeof(address.sun_path) - 1);
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// server thread needs a moment to bind, retry for up to a second
+static int connectWithRetry(int (*connectFunction)())
+{
+    for (uint32_t attempt = 0; attempt < 100; attempt++)
+    {
+        int fd = connectFunction();
+        if (fd != -1)
+        {
+            return fd;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+static bool exchange(int fd, const std::vector<uint8_t> &request,
+    std::vector<uint8_t> &response)
+{
+    if (send(fd, request.data(), request.size(), 0)
+        != static_cast<ssize_t>(request.size()))
+    {
+        return false;
+    }
+    size_t received = 0;
+    while (received < response.size())
+    {
+        ssize_t size = recv(fd, response.data() + received,
+            response.size() - received, 0);
+        if (size <= 0)
+        {
+            return false;
+        }
+        received += size;
+    }
+    return true;
+}
+
+// Returns sorted round trip times in microseconds, empty on failure
+static std::vector<double> measure(int fd, uint16_t payloadWords)
+{
+    std::vector<uint8_t> request((payloadWords + 1) * sizeof(uint32_t));
+    // command header: code in bits 0-10, length in words in bits 12-22
+    uint32_t header = 0x12 | (uint32_t(payloadWords) << 12);
+    memcpy(request.data(), &header, sizeof(header));
+    std::vector<uint8_t> response(request.size());
+
+    std::vector<double> roundTrips;
+    roundTrips.reserve(kIterations);
+    for (uint32_t i = 0; i < kIterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (!exchange(fd, request, response))
+        {
+            return std::vector<double>();
+        }
+        roundTrips.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(roundTrips.begin(), roundTrips.end());
+    return roundTrips;
+}
+
+static void printResult(const char *transport, uint16_t payloadWords,
+    const std::vector<double> &roundTrips)
+{
+    std::cout << std::setw(10) << transport
+              << std::setw(14) << (payloadWords + 1) * sizeof(uint32_t);
+    if (roundTrips.empty())
+    {
+        std::cout << "  failed: " << strerror(errno) << std::endl;
+        return;
+    }
+    double total = 0;
+    for (double roundTrip : roundTrips)
+    {
+        total += roundTrip;
+    }
+    std::cout << std::setw(12) << std::fixed << std::setprecision(1)
+              << total / roundTrips.size()
+              << std::setw(12) << roundTrips[roundTrips.size() / 2]
+              << std::setw(12) << roundTrips[roundTrips.size() * 99 / 100]
+              << std::endl;
+}
+
+int main()
+{
+    Logger::setCurrentLogLevel(Error);
+    ServerConfig config;
+    config.workers = 0;
+    config.unixSocketPath = kUnixSocketPath;
+    // server runs until the process exits, so it is never destroyed
+    TcpServer *server = new TcpServer();
+    server->setConfig(config);
+    std::thread(&TcpServer::run, server, kPortNumber,
+        MessageHandlers { &echo, nullptr, nullptr, nullptr, nullptr, nullptr }).detach();
+
+    int tcpFd = connectWithRetry(&connectTcp);
+    int unixFd = connectWithRetry(&connectUnix);
+    if (tcpFd == -1 || unixFd == -1)
+    {
+        std::cout << "Connecting to server failed: "
+                  << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "transport"
+              << std::setw(14) << "request [B]"
+              << std::setw(12) << "mean [us]"
+              << std::setw(12) << "p50 [us]"
+              << std::setw(12) << "p99 [us]" << std::endl;
+    for (uint16_t payloadWords : kPayloadWords)
+    {
+        printResult("tcp", payloadWords, measure(tcpFd, payloadWords));
+        printResult("unix", payloadWords, measure(unixFd, payloadWords));
+    }
+    close(tcpFd);
+    close(unixFd);
+    unlink(kUnixSocketPath);
+    return 0;
+}
@@ -1,7 +1,9 @@
 #!/bin/sh
 chmod +x ./fcsServer
 cp -f ./fcsServer.service /etc/systemd/system/
+cp -f ./fcsServer.socket /etc/systemd/system/
 cp -f ./fcsServer /usr/sbin/
-systemctl enable fcsServer.service
-systemctl start fcsServer.service
+systemctl daemon-reload
+systemctl enable fcsServer.socket fcsServer.service
+systemctl start fcsServer.socket fcsServer.service
 systemctl status fcsServer.service
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "CompletionQueue.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CompletionQueue::~CompletionQueue()
+{
+    if (notificationFd != -1)
+    {
+        close(notificationFd);
+    }
+}
+
+bool CompletionQueue::open()
+{
+    notificationFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notificationFd == -1)
+    {
+        Logger::logWithReturnCode("Eventfd create failed.", errno, Error);
+        return false;
+    }
+    return true;
+}
+
+void CompletionQueue::push(Completion &&completion)
+{
+    {
+        std::lock_guard<std::mutex> lock(completionsMutex);
+        completions.push_back(std::move(completion));
+    }
+    uint64_t one = 1;
+    if (write(notificationFd, &one, sizeof(one)) == -1)
+    {
+        Logger::logWithReturnCode("Eventfd write failed.", errno, Error);
+    }
+}
+
+void CompletionQueue::take(std::vector<Completion> &taken)
+{
+    uint64_t counter;
+    // resets the eventfd, completions pushed afterwards signal it again
+    if (read(notificationFd, &counter, sizeof(counter)) == -1
+        && errno != EAGAIN)
+    {
+        Logger::logWithReturnCode("Eventfd read failed.", errno, Error);
+    }
+    taken.clear();
+    std::lock_guard<std::mutex> lock(completionsMutex);
+    taken.swap(completions);
+}
@@ -0,0 +1,75 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef COMPLETIONQUEUE_H
+#define COMPLETIONQUEUE_H
+
+#include "ResponseMessage.h"
+
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+struct Completion
+{
+    uint64_t connectionToken;
+    // CommandHeader.id of the request, tells pipelined requests apart
+    uint8_t requestId;
+    ResponseMessage response;
+};
+
+/*
+Responses handed from worker threads back to the network thread owning the
+connection. Pushing signals an eventfd, which the owner polls together with
+its sockets.
+*/
+class CompletionQueue
+{
+    public:
+        ~CompletionQueue();
+
+        bool open();
+        // readable while completions are waiting to be taken
+        int getNotificationFd()
+        {
+            return notificationFd;
+        }
+        void push(Completion &&completion);
+        void take(std::vector<Completion> &taken);
+
+    private:
+        int notificationFd = -1;
+        std::mutex completionsMutex;
+        std::vector<Completion> completions;
+};
+
+#endif /* COMPLETIONQUEUE_H */
@@ -0,0 +1,81 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include "MessageFramer.h"
+#include "ResponseMessage.h"
+#include "TimerQueue.h"
+
+#include <array>
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct Connection
+{
+    // pipelined requests are told apart by the 4-bit CommandHeader.id
+    static const uint32_t kMaxRequestsInFlight = 16;
+
+    // reactor and slot index in the low half, slot generation in the high
+    // half, so stale poller events and timers never match a reused slot
+    uint64_t token = 0;
+    int fd = -1;
+    TimerQueue::Clock::time_point lastActivity;
+    MessageFramer framer;
+
+    // responses not yet accepted by the kernel, sent when socket is writable
+    std::deque<ResponseMessage> outputQueue;
+    // bytes of the front response already sent
+    size_t outputOffset = 0;
+    size_t pendingOutputBytes = 0;
+    // disconnect once all queued responses are sent
+    bool closeAfterFlush = false;
+    // draining: output is shut down and input discarded until the client
+    // closes, so unread requests do not reset the connection
+    bool discardInput = false;
+    // draining: holds state of this process, so it is served here
+    // instead of being handed over
+    bool keptInProcess = false;
+    // requests handed to workers and not completed yet
+    uint32_t requestsInFlight = 0;
+    // pipelined mode only: bit per CommandHeader.id in flight, and a copy
+    // of each such request, as they complete out of order
+    uint16_t idsInFlight = 0;
+    std::array<std::vector<uint8_t>, kMaxRequestsInFlight> pipelinedRequests;
+    // PollerEventFlags currently registered in the poller
+    uint32_t registeredEvents = 0;
+};
+
+#endif /* CONNECTION_H */
@@ -0,0 +1,92 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "ConnectionTable.h"
+
+Connection *ConnectionTable::allocate(bool ignoreLimit)
+{
+    if (activeConnections >= limit && !ignoreLimit)
+    {
+        return nullptr;
+    }
+    uint32_t slotIndex;
+    uint32_t generation = 1;
+    if (!freeSlots.empty())
+    {
+        slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+        generation = getGeneration(slots[slotIndex].token) + 1;
+        // tokens below 2^32 belong to the server's own descriptors
+        if (generation == 0)
+        {
+            generation = 1;
+        }
+    }
+    else
+    {
+        if (slots.size() >= kMaxSlots)
+        {
+            return nullptr;
+        }
+        slotIndex = slots.size();
+        slots.emplace_back();
+    }
+    Connection &connection = slots[slotIndex];
+    connection.token = (static_cast<uint64_t>(generation) << 32)
+        | reactorBits | slotIndex;
+    activeConnections++;
+    return &connection;
+}
+
+void ConnectionTable::release(Connection &connection)
+{
+    uint64_t token = connection.token;
+    connection = Connection();
+    connection.token = token;
+    freeSlots.push_back(getSlotIndex(connection.token));
+    activeConnections--;
+}
+
+Connection *ConnectionTable::find(uint64_t token)
+{
+    uint32_t slotIndex = getSlotIndex(token);
+    if (slotIndex >= slots.size())
+    {
+        return nullptr;
+    }
+    Connection &connection = slots[slotIndex];
+    if (connection.token != token || connection.fd == -1)
+    {
+        return nullptr;
+    }
+    return &connection;
+}
@@ -0,0 +1,113 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef CONNECTIONTABLE_H
+#define CONNECTIONTABLE_H
+
+#include "Connection.h"
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+Slots are created on demand up to the configured limit and recycled through
+a free list, so allocation, release and lookup by token are O(1).
+Deque keeps references to connections valid while the table grows.
+A token holds the slot's generation in its high half, the reactor index
+and slot index in its low half, so it is unique across all reactors of the
+process, e.g. as a key for per-client state shared between them.
+*/
+class ConnectionTable
+{
+    public:
+        void setLimit(size_t maxConnections)
+        {
+            limit = maxConnections;
+        }
+        // below kMaxReactors, set before the first allocation
+        void setReactorIndex(uint32_t index)
+        {
+            reactorBits = (index & (kMaxReactors - 1)) << kSlotIndexBits;
+        }
+        static const uint32_t kMaxReactors = 1 << 8;
+        static const uint32_t kMaxSlots = 1 << 24;
+
+        // nullptr when the limit is reached, unless ignoreLimit is set,
+        // and when all kMaxSlots are in use
+        Connection *allocate(bool ignoreLimit = false);
+        void release(Connection &connection);
+        // nullptr when the token belongs to an already released connection
+        Connection *find(uint64_t token);
+
+        size_t size()
+        {
+            return activeConnections;
+        }
+        size_t getLimit()
+        {
+            return limit;
+        }
+
+        template <typename Function>
+        void forEach(Function function)
+        {
+            for (Connection &connection : slots)
+            {
+                if (connection.fd != -1)
+                {
+                    function(connection);
+                }
+            }
+        }
+
+    private:
+        static const uint32_t kSlotIndexBits = 24;
+
+        static uint32_t getSlotIndex(uint64_t token)
+        {
+            return static_cast<uint32_t>(token) & (kMaxSlots - 1);
+        }
+        static uint32_t getGeneration(uint64_t token)
+        {
+            return static_cast<uint32_t>(token >> 32);
+        }
+
+        std::deque<Connection> slots;
+        std::vector<uint32_t> freeSlots;
+        size_t limit = 0;
+        size_t activeConnections = 0;
+        uint32_t reactorBits = 0;
+};
+
+#endif /* CONNECTIONTABLE_H */
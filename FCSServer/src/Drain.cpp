@@ -0,0 +1,83 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "Drain.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+Drain::~Drain()
+{
+    for (int fd : notificationFds)
+    {
+        close(fd);
+    }
+}
+
+bool Drain::open(uint32_t reactorCount)
+{
+    for (uint32_t i = 0; i < reactorCount; i++)
+    {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd == -1)
+        {
+            Logger::logWithReturnCode("Eventfd create failed.", errno, Error);
+            return false;
+        }
+        notificationFds.push_back(fd);
+    }
+    return true;
+}
+
+bool Drain::start(std::unique_ptr<HandoffChannel> newProcessChannel)
+{
+    if (started)
+    {
+        return false;
+    }
+    started = true;
+    channel = std::move(newProcessChannel);
+    reactorsRemaining = notificationFds.size();
+    // the eventfd write orders the channel before the reactors' reads
+    uint64_t one = 1;
+    for (int fd : notificationFds)
+    {
+        if (write(fd, &one, sizeof(one)) == -1)
+        {
+            Logger::logWithReturnCode("Eventfd write failed.", errno, Error);
+        }
+    }
+    return true;
+}
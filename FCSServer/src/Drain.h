@@ -0,0 +1,89 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef DRAIN_H
+#define DRAIN_H
+
+#include "HandoffChannel.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+/*
+Orderly stop of all reactors, on SIGTERM or for a hot restart. Started by
+the first reactor, then every reactor stops accepting and reading
+requests, finishes the ones already read and lets go of each connection
+once nothing of it is in flight: closes it, or hands it over to the new
+process. The last reactor to finish ends the process.
+*/
+class Drain
+{
+    public:
+        ~Drain();
+
+        // one notification eventfd per reactor
+        bool open(uint32_t reactorCount);
+        // readable once the drain has started
+        int getNotificationFd(uint32_t reactorIndex)
+        {
+            return notificationFds[reactorIndex];
+        }
+        // first reactor only; newProcessChannel is nullptr when
+        // connections are closed, false when already started
+        bool start(std::unique_ptr<HandoffChannel> newProcessChannel);
+        bool isStarted()
+        {
+            return started;
+        }
+        // nullptr unless handing over, valid in a reactor after its
+        // notification fd got readable
+        HandoffChannel *getChannel()
+        {
+            return channel.get();
+        }
+        // true for the last reactor, which then ends the process
+        bool finishReactor()
+        {
+            return reactorsRemaining.fetch_sub(1) == 1;
+        }
+
+    private:
+        std::vector<int> notificationFds;
+        std::unique_ptr<HandoffChannel> channel;
+        std::atomic<uint32_t> reactorsRemaining{0};
+        bool started = false;
+};
+
+#endif /* DRAIN_H */
@@ -0,0 +1,135 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "EpollPoller.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+EpollPoller::EpollPoller()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+    {
+        Logger::logWithReturnCode("Epoll create failed.", errno, Error);
+    }
+}
+
+EpollPoller::~EpollPoller()
+{
+    if (epollFd != -1)
+    {
+        close(epollFd);
+    }
+}
+
+bool EpollPoller::add(int fd, uint32_t events, uint64_t token)
+{
+    epoll_event event = {};
+    event.events = toEpollEvents(events);
+    event.data.u64 = token;
+    systemCallCount++;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool EpollPoller::modify(int fd, uint32_t events, uint64_t token)
+{
+    epoll_event event = {};
+    event.events = toEpollEvents(events);
+    event.data.u64 = token;
+    systemCallCount++;
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EpollPoller::remove(int fd)
+{
+    systemCallCount++;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EpollPoller::wait(
+    std::vector<PollerEvent> &readyEvents,
+    int timeoutInMilliseconds)
+{
+    readyEvents.clear();
+    systemCallCount++;
+    int numberOfEvents = epoll_wait(
+        epollFd, epollEvents, kMaxEventsPerWait, timeoutInMilliseconds);
+    for (int i = 0; i < numberOfEvents; i++)
+    {
+        readyEvents.push_back(PollerEvent {
+            epollEvents[i].data.u64,
+            fromEpollEvents(epollEvents[i].events) });
+    }
+    return numberOfEvents;
+}
+
+uint32_t EpollPoller::toEpollEvents(uint32_t events)
+{
+    uint32_t epollEvents = 0;
+    if (events & readableEvent)
+    {
+        epollEvents |= EPOLLIN;
+    }
+    if (events & writableEvent)
+    {
+        epollEvents |= EPOLLOUT;
+    }
+    if (events & edgeTriggeredEvent)
+    {
+        epollEvents |= EPOLLET;
+    }
+    return epollEvents;
+}
+
+uint32_t EpollPoller::fromEpollEvents(uint32_t epollEvents)
+{
+    uint32_t events = 0;
+    if (epollEvents & EPOLLIN)
+    {
+        events |= readableEvent;
+    }
+    if (epollEvents & EPOLLOUT)
+    {
+        events |= writableEvent;
+    }
+    if (epollEvents & EPOLLHUP)
+    {
+        events |= hangupEvent;
+    }
+    if (epollEvents & EPOLLERR)
+    {
+        events |= errorEvent;
+    }
+    return events;
+}
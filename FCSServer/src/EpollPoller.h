@@ -0,0 +1,71 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef EPOLLPOLLER_H
+#define EPOLLPOLLER_H
+
+#include "Poller.h"
+
+#include <sys/epoll.h>
+
+class EpollPoller : public Poller
+{
+    public:
+        EpollPoller();
+        ~EpollPoller() override;
+
+        bool isValid()
+        {
+            return epollFd != -1;
+        }
+        bool add(int fd, uint32_t events, uint64_t token) override;
+        bool modify(int fd, uint32_t events, uint64_t token) override;
+        void remove(int fd) override;
+        int wait(
+            std::vector<PollerEvent> &readyEvents,
+            int timeoutInMilliseconds) override;
+        const char *getName() override
+        {
+            return "epoll";
+        }
+
+    private:
+        static uint32_t toEpollEvents(uint32_t events);
+        static uint32_t fromEpollEvents(uint32_t epollEvents);
+
+        static const uint32_t kMaxEventsPerWait = 64;
+
+        int epollFd = -1;
+        epoll_event epollEvents[kMaxEventsPerWait];
+};
+
+#endif /* EPOLLPOLLER_H */
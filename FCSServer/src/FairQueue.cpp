@@ -0,0 +1,195 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "FairQueue.h"
+#include "utils.h"
+#include "VerifierProtocol.h"
+
+#include <algorithm>
+
+void FairQueue::setRateLimit(uint32_t requestsPerSecond, uint32_t burstSize)
+{
+    rate = requestsPerSecond;
+    burst = std::max(burstSize > 0 ? burstSize : requestsPerSecond, 1u);
+}
+
+bool FairQueue::push(QueuedRequest &&request, Clock::time_point now)
+{
+    CommandHeader header;
+    if (request.message.size() >= CommandHeader::getRequiredSize())
+    {
+        header.parse(request.message);
+    }
+    request.commandCode = header.code;
+
+    if (++pushesSinceSweep >= kIdleSweepInterval)
+    {
+        removeIdle(now);
+        pushesSinceSweep = 0;
+    }
+
+    if (rate > 0)
+    {
+        auto inserted = buckets.emplace(request.connectionToken, Bucket());
+        Bucket &bucket = inserted.first->second;
+        if (inserted.second)
+        {
+            bucket.tokens = burst;
+            bucket.lastRefill = now;
+        }
+        refill(bucket, now);
+        uint32_t cost = countRequests(header, request.message);
+        if (bucket.tokens < cost)
+        {
+            return false;
+        }
+        bucket.tokens -= cost;
+    }
+
+    ClientKey key(request.connectionToken, header.client);
+    Client &client = clients[key];
+    if (client.requests.empty())
+    {
+        activeClients.push_back(key);
+    }
+    client.requests.push_back(std::move(request));
+    queuedRequests++;
+    return true;
+}
+
+bool FairQueue::pop(QueuedRequest &request)
+{
+    // every pass adds a quantum to a client that cannot afford its next
+    // request, so some client affords one eventually
+    while (!activeClients.empty())
+    {
+        Client &client = clients[activeClients.front()];
+        uint64_t cost = getExpectedServiceTime(
+            client.requests.front().commandCode);
+        if (client.deficit < cost)
+        {
+            client.deficit += kQuantumInMicroseconds;
+            activeClients.push_back(activeClients.front());
+            activeClients.pop_front();
+            continue;
+        }
+        client.deficit -= cost;
+        request = std::move(client.requests.front());
+        client.requests.pop_front();
+        queuedRequests--;
+        if (client.requests.empty())
+        {
+            // unused deficit is not saved up while idle
+            client.deficit = 0;
+            activeClients.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void FairQueue::recordServiceTime(uint16_t commandCode, uint64_t microseconds)
+{
+    auto itr = serviceTimes.find(commandCode);
+    if (itr == serviceTimes.end())
+    {
+        serviceTimes[commandCode] = microseconds;
+        return;
+    }
+    itr->second = (itr->second * 7 + microseconds) / 8;
+}
+
+uint32_t FairQueue::countRequests(
+    const CommandHeader &header, BufferView message)
+{
+    if (header.code != batchRequest)
+    {
+        return 1;
+    }
+    // headers are only walked, a malformed batch is answered by its handler
+    uint32_t count = 0;
+    size_t offset = CommandHeader::getRequiredSize();
+    while (offset + CommandHeader::getRequiredSize() <= message.size())
+    {
+        CommandHeader subHeader;
+        subHeader.parse(message, offset);
+        offset += CommandHeader::getRequiredSize()
+            + subHeader.length * WORD_SIZE;
+        count++;
+    }
+    return std::max(count, 1u);
+}
+
+void FairQueue::refill(Bucket &bucket, Clock::time_point now)
+{
+    double elapsedSeconds =
+        std::chrono::duration<double>(now - bucket.lastRefill).count();
+    bucket.tokens = std::min<double>(burst, bucket.tokens + elapsedSeconds * rate);
+    bucket.lastRefill = now;
+}
+
+uint64_t FairQueue::getExpectedServiceTime(uint16_t commandCode)
+{
+    // unknown commands cost a quantum until first measured
+    auto itr = serviceTimes.find(commandCode);
+    return itr == serviceTimes.end()
+        ? kQuantumInMicroseconds : std::max<uint64_t>(itr->second, 1);
+}
+
+void FairQueue::removeIdle(Clock::time_point now)
+{
+    // an empty queue and a full bucket hold no state worth keeping,
+    // so a connection closing leaves nothing behind
+    for (auto itr = clients.begin(); itr != clients.end();)
+    {
+        if (itr->second.requests.empty())
+        {
+            itr = clients.erase(itr);
+        }
+        else
+        {
+            itr++;
+        }
+    }
+    for (auto itr = buckets.begin(); itr != buckets.end();)
+    {
+        refill(itr->second, now);
+        if (itr->second.tokens >= burst)
+        {
+            itr = buckets.erase(itr);
+        }
+        else
+        {
+            itr++;
+        }
+    }
+}
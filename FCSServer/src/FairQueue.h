@@ -0,0 +1,125 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef FAIRQUEUE_H
+#define FAIRQUEUE_H
+
+#include "BufferView.h"
+#include "CommandHeader.h"
+#include "CompletionQueue.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+struct QueuedRequest
+{
+    CompletionQueue *completionQueue;
+    uint64_t connectionToken;
+    uint8_t requestId;
+    BufferView message;
+    std::chrono::steady_clock::time_point submitTime;
+    // set by FairQueue from the command header
+    uint16_t commandCode = 0;
+};
+
+/*
+Requests waiting for the SDM mailbox, one queue per connection and
+CommandHeader.client. Connection tokens are unique across reactors. Queues
+are served by deficit round robin on the expected service time of each
+command, so a client sending many or slow requests cannot starve the others.
+Optional token buckets cap the request rate of each connection; the client
+field is chosen by the peer, so it does not get a bucket of its own. Not
+thread safe, RequestExecutor locks around it.
+*/
+class FairQueue
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        // 0 requests per second disables rate limiting, 0 burst means the rate
+        void setRateLimit(uint32_t requestsPerSecond, uint32_t burst);
+        // false when the connection has no budget left, request is not queued;
+        // a batch takes one token per request it carries
+        bool push(QueuedRequest &&request, Clock::time_point now);
+        bool pop(QueuedRequest &request);
+        void recordServiceTime(uint16_t commandCode, uint64_t microseconds);
+        size_t size()
+        {
+            return queuedRequests;
+        }
+
+    private:
+        typedef std::pair<uint64_t, uint8_t> ClientKey;
+
+        struct Client
+        {
+            std::deque<QueuedRequest> requests;
+            // service time in microseconds the client may still use this round
+            uint64_t deficit = 0;
+        };
+
+        struct Bucket
+        {
+            double tokens = 0;
+            Clock::time_point lastRefill;
+        };
+
+        static uint32_t countRequests(
+            const CommandHeader &header, BufferView message);
+        void refill(Bucket &bucket, Clock::time_point now);
+        uint64_t getExpectedServiceTime(uint16_t commandCode);
+        void removeIdle(Clock::time_point now);
+
+        // service time added to a client's deficit each round
+        static const uint64_t kQuantumInMicroseconds = 1000;
+        // idle clients and buckets are looked for after this many pushes
+        static const uint32_t kIdleSweepInterval = 1024;
+
+        uint32_t rate = 0;
+        uint32_t burst = 0;
+        std::map<ClientKey, Client> clients;
+        // rate budget per connection token
+        std::unordered_map<uint64_t, Bucket> buckets;
+        // clients with queued requests, in round robin order
+        std::deque<ClientKey> activeClients;
+        // moving average per command code
+        std::unordered_map<uint16_t, uint64_t> serviceTimes;
+        size_t queuedRequests = 0;
+        uint32_t pushesSinceSweep = 0;
+};
+
+#endif /* FAIRQUEUE_H */
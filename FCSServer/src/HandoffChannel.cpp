@@ -0,0 +1,239 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "HandoffChannel.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    bool makeAddress(const std::string &path, sockaddr_un &address)
+    {
+        address = {};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            Logger::log("Hot restart socket path invalid: " + path, Error);
+            return false;
+        }
+        path.copy(address.sun_path, path.size());
+        return true;
+    }
+}
+
+HandoffChannel::~HandoffChannel()
+{
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+int HandoffChannel::connect(const std::string &path)
+{
+    sockaddr_un address;
+    if (!makeAddress(path, address))
+    {
+        return -1;
+    }
+    int socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socketFd == -1)
+    {
+        return -1;
+    }
+    if (::connect(socketFd, (sockaddr*)&address, sizeof(address)) == -1)
+    {
+        // ENOENT or ECONNREFUSED: nobody to take over from
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+int HandoffChannel::listen(const std::string &path)
+{
+    sockaddr_un address;
+    if (!makeAddress(path, address))
+    {
+        return -1;
+    }
+    int listenerFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenerFd == -1)
+    {
+        Logger::logWithReturnCode("Could not create hot restart socket.", errno, Error);
+        return -1;
+    }
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+    {
+        unlink(path.c_str());
+    }
+    // whoever connects receives all client connections
+    mode_t previousMask = umask(0177);
+    int bindResult = bind(listenerFd, (sockaddr*)&address, sizeof(address));
+    umask(previousMask);
+    if (bindResult == -1 || ::listen(listenerFd, 1) == -1)
+    {
+        Logger::logWithReturnCode("Hot restart socket setup failed.", errno, Error);
+        close(listenerFd);
+        return -1;
+    }
+    return listenerFd;
+}
+
+int HandoffChannel::accept(int listenerFd)
+{
+    int socketFd = accept4(listenerFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (socketFd == -1)
+    {
+        return -1;
+    }
+    ucred credentials;
+    socklen_t credentialsSize = sizeof(credentials);
+    if (getsockopt(socketFd, SOL_SOCKET, SO_PEERCRED,
+            &credentials, &credentialsSize) == -1
+        || credentials.uid != geteuid())
+    {
+        Logger::log("Hot restart refused, peer runs as another user", Error);
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+bool HandoffChannel::send(MessageType type, int passedFd, BufferView data)
+{
+    MessageHeader header = {};
+    header.type = type;
+    header.size = data.size();
+    iovec iovecs[2] = {
+        { &header, sizeof(header) },
+        { const_cast<uint8_t*>(data.data()), data.size() }
+    };
+    msghdr message = {};
+    message.msg_iov = iovecs;
+    message.msg_iovlen = data.size() > 0 ? 2 : 1;
+    // file descriptor travels with the first byte of the header
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    if (passedFd != -1)
+    {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr *controlMessage = CMSG_FIRSTHDR(&message);
+        controlMessage->cmsg_level = SOL_SOCKET;
+        controlMessage->cmsg_type = SCM_RIGHTS;
+        controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(controlMessage), &passedFd, sizeof(int));
+    }
+
+    std::lock_guard<std::mutex> lock(sendMutex);
+    size_t expectedSize = sizeof(header) + data.size();
+    ssize_t sentSize;
+    do
+    {
+        sentSize = sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (sentSize == -1 && errno == EINTR);
+    // blocking socket writes whole messages, unless the peer is gone
+    if (sentSize != static_cast<ssize_t>(expectedSize))
+    {
+        Logger::logWithReturnCode("Hot restart send failed.", errno, Error);
+        return false;
+    }
+    return true;
+}
+
+bool HandoffChannel::receive(
+    MessageType &type, int &passedFd, std::vector<uint8_t> &data)
+{
+    passedFd = -1;
+    MessageHeader header;
+    iovec headerIovec = { &header, sizeof(header) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr message = {};
+    message.msg_iov = &headerIovec;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t receivedSize;
+    do
+    {
+        receivedSize = recvmsg(fd, &message, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    } while (receivedSize == -1 && errno == EINTR);
+    cmsghdr *controlMessage = receivedSize > 0 ? CMSG_FIRSTHDR(&message) : nullptr;
+    if (controlMessage != nullptr
+        && controlMessage->cmsg_level == SOL_SOCKET
+        && controlMessage->cmsg_type == SCM_RIGHTS
+        && controlMessage->cmsg_len == CMSG_LEN(sizeof(int)))
+    {
+        memcpy(&passedFd, CMSG_DATA(controlMessage), sizeof(int));
+    }
+    if (receivedSize != sizeof(header) || header.size > kMaxMessageSizeInBytes)
+    {
+        if (receivedSize == -1)
+        {
+            Logger::logWithReturnCode("Hot restart receive failed.", errno, Error);
+        }
+        if (passedFd != -1)
+        {
+            close(passedFd);
+            passedFd = -1;
+        }
+        return false;
+    }
+
+    data.resize(header.size);
+    size_t receivedTotal = 0;
+    while (receivedTotal < data.size())
+    {
+        receivedSize = recv(fd, data.data() + receivedTotal,
+            data.size() - receivedTotal, MSG_WAITALL);
+        if (receivedSize == 0 || (receivedSize == -1 && errno != EINTR))
+        {
+            if (passedFd != -1)
+            {
+                close(passedFd);
+                passedFd = -1;
+            }
+            return false;
+        }
+        receivedTotal += receivedSize == -1 ? 0 : receivedSize;
+    }
+    type = static_cast<MessageType>(header.type);
+    return true;
+}
@@ -0,0 +1,113 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#ifndef HANDOFFCHANNEL_H
+#define HANDOFFCHANNEL_H
+
+#include "BufferView.h"
+
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+Unix stream connection between the running and the new server process of
+a hot restart. A message is a type and optional bytes, with at most one
+file descriptor passed along (SCM_RIGHTS). The socket is blocking: the
+sender writes each message in one call, so a receiver woken by the poller
+reads it without waiting. Sends are serialized, all reactors share it.
+*/
+class HandoffChannel
+{
+    public:
+        enum MessageType : uint8_t
+        {
+            serverSocket = 1,
+            // data is 1 when the receiver removes the socket file on exit
+            unixSocket = 2,
+            // listening sockets are sent, connections follow
+            listenersDone = 3,
+            // idle client connection with any request bytes already read
+            connection = 4,
+            // all connections are sent, sender exits
+            done = 5
+        };
+
+        // takes ownership of the connected socket
+        explicit HandoffChannel(int socketFd) : fd(socketFd)
+        {
+        }
+        ~HandoffChannel();
+        HandoffChannel(const HandoffChannel&) = delete;
+        HandoffChannel &operator=(const HandoffChannel&) = delete;
+
+        // -1 when no server listens at the path
+        static int connect(const std::string &path);
+        // non-blocking control socket accessible to the owner only,
+        // a stale socket file at the path is replaced; -1 on failure
+        static int listen(const std::string &path);
+        // -1 unless the peer runs as the same user as this process
+        static int accept(int listenerFd);
+
+        int getFd()
+        {
+            return fd;
+        }
+        // caller owns the socket afterwards
+        int release()
+        {
+            int releasedFd = fd;
+            fd = -1;
+            return releasedFd;
+        }
+        // passedFd -1 sends no file descriptor
+        bool send(MessageType type, int passedFd, BufferView data = BufferView());
+        // passedFd is -1 when none came with the message
+        bool receive(MessageType &type, int &passedFd, std::vector<uint8_t> &data);
+
+    private:
+        struct MessageHeader
+        {
+            uint8_t type;
+            uint8_t reserved[3];
+            uint32_t size;
+        };
+        // a connection carries at most a partially received frame
+        static const uint32_t kMaxMessageSizeInBytes = 64 * 1024;
+
+        int fd;
+        std::mutex sendMutex;
+};
+
+#endif /* HANDOFFCHANNEL_H */
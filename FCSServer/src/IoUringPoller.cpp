@@ -0,0 +1,375 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "IoUringPoller.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+IoUringPoller::IoUringPoller()
+{
+    if (!setupRings())
+    {
+        closeRings();
+        return;
+    }
+    if (!supportsMultishotPoll())
+    {
+        Logger::log("Io_uring multishot poll not supported", Error);
+        closeRings();
+        return;
+    }
+    systemCallCount = 0;
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    closeRings();
+}
+
+bool IoUringPoller::setupRings()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = kCompletionEntries;
+    ringFd = syscall(__NR_io_uring_setup, kSubmissionEntries, &params);
+    if (ringFd == -1)
+    {
+        Logger::logWithReturnCode("Io_uring setup failed.", errno, Error);
+        return false;
+    }
+    // timeout passed to io_uring_enter and one mapping for both rings
+    uint32_t requiredFeatures
+        = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & requiredFeatures) != requiredFeatures)
+    {
+        Logger::log("Io_uring features missing: "
+            + std::to_string(params.features), Error);
+        return false;
+    }
+
+    size_t submissionRingSize
+        = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t completionRingSize
+        = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ringMemorySize = std::max(submissionRingSize, completionRingSize);
+    ringMemory = mmap(nullptr, ringMemorySize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (ringMemory == MAP_FAILED)
+    {
+        ringMemory = nullptr;
+        Logger::logWithReturnCode("Io_uring ring mmap failed.", errno, Error);
+        return false;
+    }
+    submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *entries = mmap(nullptr, submissionEntriesSize,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd, IORING_OFF_SQES);
+    if (entries == MAP_FAILED)
+    {
+        Logger::logWithReturnCode("Io_uring sqe mmap failed.", errno, Error);
+        return false;
+    }
+    submissionEntries = static_cast<io_uring_sqe*>(entries);
+
+    uint8_t *ring = static_cast<uint8_t*>(ringMemory);
+    submissionHead = reinterpret_cast<uint32_t*>(ring + params.sq_off.head);
+    submissionTail = reinterpret_cast<uint32_t*>(ring + params.sq_off.tail);
+    submissionMask = *reinterpret_cast<uint32_t*>(
+        ring + params.sq_off.ring_mask);
+    submissionRingEntries = params.sq_entries;
+    submissionArray = reinterpret_cast<uint32_t*>(ring + params.sq_off.array);
+    completionHead = reinterpret_cast<uint32_t*>(ring + params.cq_off.head);
+    completionTail = reinterpret_cast<uint32_t*>(ring + params.cq_off.tail);
+    completionMask = *reinterpret_cast<uint32_t*>(
+        ring + params.cq_off.ring_mask);
+    completionEntries = reinterpret_cast<io_uring_cqe*>(
+        ring + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUringPoller::supportsMultishotPoll()
+{
+    // older kernels fail IORING_POLL_ADD_MULTI with -EINVAL,
+    // try it on an eventfd before the server relies on it
+    int testFd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (testFd == -1)
+    {
+        return false;
+    }
+    std::vector<PollerEvent> readyEvents;
+    bool supported = add(testFd, readableEvent, 0)
+        && wait(readyEvents, 1000) == 1
+        && readyEvents[0].events == readableEvent;
+    remove(testFd);
+    wait(readyEvents, 0);
+    close(testFd);
+    return supported;
+}
+
+void IoUringPoller::closeRings()
+{
+    if (submissionEntries != nullptr)
+    {
+        munmap(submissionEntries, submissionEntriesSize);
+        submissionEntries = nullptr;
+    }
+    if (ringMemory != nullptr)
+    {
+        munmap(ringMemory, ringMemorySize);
+        ringMemory = nullptr;
+    }
+    if (ringFd != -1)
+    {
+        close(ringFd);
+        ringFd = -1;
+    }
+}
+
+bool IoUringPoller::add(int fd, uint32_t events, uint64_t token)
+{
+    if (userDataByFd.count(fd) != 0)
+    {
+        errno = EEXIST;
+        return false;
+    }
+    uint64_t userData = nextUserData++;
+    Registration &registration = registrations[userData];
+    registration = Registration { fd, toPollEvents(events), token, 0 };
+    userDataByFd[fd] = userData;
+    queuePoll(userData, registration);
+    return true;
+}
+
+bool IoUringPoller::modify(int fd, uint32_t events, uint64_t token)
+{
+    if (userDataByFd.count(fd) == 0)
+    {
+        errno = ENOENT;
+        return false;
+    }
+    // replaced rather than updated in place, the new poll reports
+    // current readiness on arming just like EPOLL_CTL_MOD
+    remove(fd);
+    return add(fd, events, token);
+}
+
+void IoUringPoller::remove(int fd)
+{
+    auto itr = userDataByFd.find(fd);
+    if (itr == userDataByFd.end())
+    {
+        return;
+    }
+    queuePollRemove(itr->second);
+    registrations.erase(itr->second);
+    userDataByFd.erase(itr);
+}
+
+int IoUringPoller::wait(
+    std::vector<PollerEvent> &readyEvents,
+    int timeoutInMilliseconds)
+{
+    readyEvents.clear();
+    uint32_t minComplete
+        = (timeoutInMilliseconds == 0 || hasCompletions()) ? 0 : 1;
+    if ((minComplete > 0 || getPendingSubmissions() > 0)
+        && enter(minComplete, timeoutInMilliseconds) == -1)
+    {
+        return -1;
+    }
+    reapCompletions(readyEvents);
+    return readyEvents.size();
+}
+
+io_uring_sqe *IoUringPoller::getSubmissionEntry()
+{
+    if (getPendingSubmissions() == submissionRingEntries)
+    {
+        enter(0, 0);
+    }
+    uint32_t tail = *submissionTail;
+    uint32_t index = tail & submissionMask;
+    io_uring_sqe *entry = &submissionEntries[index];
+    memset(entry, 0, sizeof(*entry));
+    submissionArray[index] = index;
+    // entry is published together with the tail
+    __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+    return entry;
+}
+
+void IoUringPoller::queuePoll(
+    uint64_t userData, const Registration &registration)
+{
+    io_uring_sqe *entry = getSubmissionEntry();
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->fd = registration.fd;
+    entry->poll32_events = registration.pollEvents;
+    entry->len = IORING_POLL_ADD_MULTI;
+    entry->user_data = userData;
+}
+
+void IoUringPoller::queuePollRemove(uint64_t userData)
+{
+    io_uring_sqe *entry = getSubmissionEntry();
+    entry->opcode = IORING_OP_POLL_REMOVE;
+    entry->fd = -1;
+    entry->addr = userData;
+    entry->user_data = kIgnoredUserData;
+}
+
+int IoUringPoller::enter(uint32_t minComplete, int timeoutInMilliseconds)
+{
+    uint32_t flags = 0;
+    io_uring_getevents_arg argument;
+    memset(&argument, 0, sizeof(argument));
+    timespec timeout;
+    if (minComplete > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeoutInMilliseconds >= 0)
+        {
+            timeout.tv_sec = timeoutInMilliseconds / 1000;
+            timeout.tv_nsec = (timeoutInMilliseconds % 1000) * 1000000L;
+            argument.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+    systemCallCount++;
+    int result = syscall(__NR_io_uring_enter, ringFd,
+        getPendingSubmissions(), minComplete, flags,
+        &argument, sizeof(argument));
+    if (result == -1 && (errno == ETIME || errno == EINTR))
+    {
+        return 0;
+    }
+    return result;
+}
+
+uint32_t IoUringPoller::getPendingSubmissions()
+{
+    return *submissionTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+}
+
+bool IoUringPoller::hasCompletions()
+{
+    return *completionHead != __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+}
+
+void IoUringPoller::reapCompletions(std::vector<PollerEvent> &readyEvents)
+{
+    uint32_t head = *completionHead;
+    uint32_t tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        const io_uring_cqe &completion = completionEntries[head & completionMask];
+        auto itr = registrations.find(completion.user_data);
+        if (itr == registrations.end())
+        {
+            // removal itself or a poll removed since it completed
+            continue;
+        }
+        if (completion.res < 0)
+        {
+            // a failed poll is not armed anymore, nothing would be
+            // reported for the descriptor again unless it is re-queued
+            Logger::logWithReturnCode("Io_uring poll failed.",
+                -completion.res, Error);
+            if (++itr->second.failedPolls > kMaxPollRetries)
+            {
+                readyEvents.push_back(
+                    PollerEvent { itr->second.token, errorEvent });
+                continue;
+            }
+            queuePoll(itr->first, itr->second);
+            continue;
+        }
+        itr->second.failedPolls = 0;
+        readyEvents.push_back(PollerEvent {
+            itr->second.token, fromPollEvents(completion.res) });
+        if (!(completion.flags & IORING_CQE_F_MORE))
+        {
+            // kernel ended the multishot poll, e.g. on completion overflow
+            queuePoll(itr->first, itr->second);
+        }
+    }
+    __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+}
+
+uint32_t IoUringPoller::toPollEvents(uint32_t events)
+{
+    uint32_t pollEvents = 0;
+    if (events & readableEvent)
+    {
+        pollEvents |= POLLIN;
+    }
+    if (events & writableEvent)
+    {
+        pollEvents |= POLLOUT;
+    }
+    if (events & edgeTriggeredEvent)
+    {
+        pollEvents |= EPOLLET;
+    }
+    return pollEvents;
+}
+
+uint32_t IoUringPoller::fromPollEvents(uint32_t pollEvents)
+{
+    uint32_t events = 0;
+    if (pollEvents & POLLIN)
+    {
+        events |= readableEvent;
+    }
+    if (pollEvents & POLLOUT)
+    {
+        events |= writableEvent;
+    }
+    if (pollEvents & POLLHUP)
+    {
+        events |= hangupEvent;
+    }
+    if (pollEvents & POLLERR)
+    {
+        events |= errorEvent;
+    }
+    return events;
+}
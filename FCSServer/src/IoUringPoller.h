@@ -0,0 +1,127 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef IOURINGPOLLER_H
+#define IOURINGPOLLER_H
+
+#include "Poller.h"
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+#include <unordered_map>
+
+/*
+Readiness backend on top of io_uring multishot poll requests. Only readiness
+goes through the ring: accept, recv and send are still regular system calls
+made by TcpServer once a descriptor is reported, exactly as with epoll.
+A multishot poll stays armed after reporting, and add, modify and remove are
+queued in the submission ring and handed to the kernel with the next wait,
+which saves the epoll_ctl call per registration change and nothing more.
+Uses raw system calls, liburing is not required.
+*/
+class IoUringPoller : public Poller
+{
+    public:
+        IoUringPoller();
+        ~IoUringPoller() override;
+
+        // false when kernel lacks io_uring or multishot poll
+        bool isValid()
+        {
+            return ringFd != -1;
+        }
+        bool add(int fd, uint32_t events, uint64_t token) override;
+        bool modify(int fd, uint32_t events, uint64_t token) override;
+        void remove(int fd) override;
+        int wait(
+            std::vector<PollerEvent> &readyEvents,
+            int timeoutInMilliseconds) override;
+        const char *getName() override
+        {
+            return "io_uring";
+        }
+
+    private:
+        struct Registration
+        {
+            int fd;
+            uint32_t pollEvents;
+            uint64_t token;
+            // polls failed in a row, re-armed up to kMaxPollRetries
+            uint32_t failedPolls;
+        };
+
+        bool setupRings();
+        bool supportsMultishotPoll();
+        void closeRings();
+        io_uring_sqe *getSubmissionEntry();
+        void queuePoll(uint64_t userData, const Registration &registration);
+        void queuePollRemove(uint64_t userData);
+        int enter(uint32_t minComplete, int timeoutInMilliseconds);
+        uint32_t getPendingSubmissions();
+        bool hasCompletions();
+        void reapCompletions(std::vector<PollerEvent> &readyEvents);
+        static uint32_t toPollEvents(uint32_t events);
+        static uint32_t fromPollEvents(uint32_t pollEvents);
+
+        static const uint32_t kSubmissionEntries = 256;
+        // multishot polls of all connections may complete at once
+        static const uint32_t kCompletionEntries = 4096;
+        // completions of removals carry this user data and are skipped
+        static const uint64_t kIgnoredUserData = 0;
+        // a poll failing more often in a row is reported as errorEvent
+        static const uint32_t kMaxPollRetries = 3;
+
+        int ringFd = -1;
+        void *ringMemory = nullptr;
+        size_t ringMemorySize = 0;
+        io_uring_sqe *submissionEntries = nullptr;
+        size_t submissionEntriesSize = 0;
+
+        uint32_t *submissionHead = nullptr;
+        uint32_t *submissionTail = nullptr;
+        uint32_t submissionMask = 0;
+        uint32_t submissionRingEntries = 0;
+        uint32_t *submissionArray = nullptr;
+        uint32_t *completionHead = nullptr;
+        uint32_t *completionTail = nullptr;
+        uint32_t completionMask = 0;
+        io_uring_cqe *completionEntries = nullptr;
+
+        // user data is unique per registration, so completions of a poll
+        // removed or replaced earlier never match a reused fd
+        std::unordered_map<uint64_t, Registration> registrations;
+        std::unordered_map<int, uint64_t> userDataByFd;
+        uint64_t nextUserData = kIgnoredUserData + 1;
+};
+
+#endif /* IOURINGPOLLER_H */
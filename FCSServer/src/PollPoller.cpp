@@ -0,0 +1,148 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "Logger.h"
+#include "PollPoller.h"
+
+#include <errno.h>
+
+bool PollPoller::add(int fd, uint32_t events, uint64_t token)
+{
+    if (indexByFd.find(fd) != indexByFd.end())
+    {
+        errno = EEXIST;
+        return false;
+    }
+    pollfd entry;
+    entry.fd = fd;
+    entry.events = toPollEvents(events);
+    entry.revents = 0;
+    indexByFd[fd] = pollFds.size();
+    pollFds.push_back(entry);
+    tokens.push_back(token);
+    return true;
+}
+
+bool PollPoller::modify(int fd, uint32_t events, uint64_t token)
+{
+    auto itr = indexByFd.find(fd);
+    if (itr == indexByFd.end())
+    {
+        errno = ENOENT;
+        return false;
+    }
+    pollFds[itr->second].events = toPollEvents(events);
+    tokens[itr->second] = token;
+    return true;
+}
+
+void PollPoller::remove(int fd)
+{
+    auto itr = indexByFd.find(fd);
+    if (itr == indexByFd.end())
+    {
+        return;
+    }
+    size_t index = itr->second;
+    size_t lastIndex = pollFds.size() - 1;
+    if (index != lastIndex)
+    {
+        pollFds[index] = pollFds[lastIndex];
+        tokens[index] = tokens[lastIndex];
+        indexByFd[pollFds[index].fd] = index;
+    }
+    pollFds.pop_back();
+    tokens.pop_back();
+    indexByFd.erase(itr);
+}
+
+int PollPoller::wait(
+    std::vector<PollerEvent> &readyEvents,
+    int timeoutInMilliseconds)
+{
+    readyEvents.clear();
+    systemCallCount++;
+    int numberOfEvents = poll(
+        pollFds.data(), pollFds.size(), timeoutInMilliseconds);
+    if (numberOfEvents <= 0)
+    {
+        return numberOfEvents;
+    }
+    for (size_t i = 0;
+        i < pollFds.size() && readyEvents.size() < (size_t)numberOfEvents;
+        i++)
+    {
+        if (pollFds[i].revents != 0)
+        {
+            readyEvents.push_back(
+                PollerEvent { tokens[i], fromPollEvents(pollFds[i].revents) });
+            pollFds[i].revents = 0;
+        }
+    }
+    return readyEvents.size();
+}
+
+short PollPoller::toPollEvents(uint32_t events)
+{
+    short pollEvents = 0;
+    if (events & readableEvent)
+    {
+        pollEvents |= POLLIN;
+    }
+    if (events & writableEvent)
+    {
+        pollEvents |= POLLOUT;
+    }
+    return pollEvents;
+}
+
+uint32_t PollPoller::fromPollEvents(short revents)
+{
+    uint32_t events = 0;
+    if (revents & POLLIN)
+    {
+        events |= readableEvent;
+    }
+    if (revents & POLLOUT)
+    {
+        events |= writableEvent;
+    }
+    if (revents & POLLHUP)
+    {
+        events |= hangupEvent;
+    }
+    if (revents & (POLLERR | POLLNVAL))
+    {
+        events |= errorEvent;
+    }
+    return events;
+}
@@ -0,0 +1,80 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Poller.h"
+#include "PollPoller.h"
+
+std::unique_ptr<Poller> Poller::create(PollerBackend backend)
+{
+    if (backend == ioUringBackend)
+    {
+        std::unique_ptr<IoUringPoller> ioUringPoller(new IoUringPoller());
+        if (ioUringPoller->isValid())
+        {
+            return ioUringPoller;
+        }
+        Logger::log("Io_uring unavailable, falling back to epoll", Warning);
+    }
+    if (backend == epollBackend || backend == ioUringBackend)
+    {
+        std::unique_ptr<EpollPoller> epollPoller(new EpollPoller());
+        if (epollPoller->isValid())
+        {
+            return epollPoller;
+        }
+        Logger::log("Epoll unavailable, falling back to poll", Warning);
+    }
+    return std::unique_ptr<Poller>(new PollPoller());
+}
+
+bool Poller::parseBackend(const std::string &name, PollerBackend &backend)
+{
+    if (name == "epoll")
+    {
+        backend = epollBackend;
+        return true;
+    }
+    if (name == "io_uring")
+    {
+        backend = ioUringBackend;
+        return true;
+    }
+    if (name == "poll")
+    {
+        backend = pollBackend;
+        return true;
+    }
+    return false;
+}
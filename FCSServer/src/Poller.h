@@ -0,0 +1,92 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef POLLER_H
+#define POLLER_H
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum PollerBackend
+{
+    pollBackend,
+    epollBackend,
+    ioUringBackend
+};
+
+enum PollerEventFlags
+{
+    readableEvent = 0x01,
+    writableEvent = 0x02,
+    hangupEvent = 0x04,
+    errorEvent = 0x08,
+    // Only a hint - backends without edge triggering report level events,
+    // which is fine as long as the caller drains the socket until EAGAIN
+    edgeTriggeredEvent = 0x10
+};
+
+struct PollerEvent
+{
+    uint64_t token;
+    uint32_t events;
+};
+
+class Poller
+{
+    public:
+        virtual ~Poller() = default;
+
+        virtual bool add(int fd, uint32_t events, uint64_t token) = 0;
+        virtual bool modify(int fd, uint32_t events, uint64_t token) = 0;
+        virtual void remove(int fd) = 0;
+        // Returns number of ready events stored in readyEvents, -1 on error
+        virtual int wait(
+            std::vector<PollerEvent> &readyEvents,
+            int timeoutInMilliseconds) = 0;
+        virtual const char *getName() = 0;
+        // system calls made by the poller itself, for benchmarking
+        uint64_t getSystemCallCount()
+        {
+            return systemCallCount;
+        }
+
+        static std::unique_ptr<Poller> create(PollerBackend backend);
+        static bool parseBackend(
+            const std::string &name, PollerBackend &backend);
+
+    protected:
+        uint64_t systemCallCount = 0;
+};
+
+#endif /* POLLER_H */
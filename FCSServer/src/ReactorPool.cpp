@@ -0,0 +1,102 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "Logger.h"
+#include "ReactorPool.h"
+
+#include <algorithm>
+#include <signal.h>
+#include <thread>
+
+void ReactorPool::run(uint32_t portNumber, const MessageHandlers &handlers)
+{
+    if (config.workers > 0)
+    {
+        executor = std::make_unique<RequestExecutor>(handlers, config.workers);
+        executor->setRateLimit(
+            config.clientRequestRate, config.clientRequestBurst);
+        executor->setLoadShedding(
+            config.shedPendingRequests, config.shedServiceTimeInMilliseconds);
+        if (!executor->start())
+        {
+            Logger::log("Request executor setup failed.", Fatal);
+            exit(1);
+        }
+    }
+    else if (config.clientRequestRate > 0
+        || config.shedPendingRequests > 0
+        || config.shedServiceTimeInMilliseconds > 0)
+    {
+        Logger::log("Client request rate and load shedding are only enforced with workers, ignored", Warning);
+    }
+
+    uint32_t reactorCount = std::max(config.reactors, 1u);
+    if (!drain.open(reactorCount))
+    {
+        Logger::log("Drain setup failed.", Fatal);
+        exit(1);
+    }
+    ServerConfig reactorConfig = getReactorConfig(config);
+    for (uint32_t i = 0; i < reactorCount; i++)
+    {
+        reactors.push_back(std::make_unique<TcpServer>());
+        reactors[i]->setConfig(reactorConfig);
+        reactors[i]->setExecutor(executor.get());
+        reactors[i]->setReactorIndex(i);
+        reactors[i]->setDrain(&drain);
+    }
+
+    // reactor threads inherit the mask, so termination signals
+    // are handled on the main thread
+    sigset_t blockedSignals;
+    sigset_t previousSignals;
+    sigfillset(&blockedSignals);
+    pthread_sigmask(SIG_BLOCK, &blockedSignals, &previousSignals);
+    for (uint32_t i = 1; i < reactorCount; i++)
+    {
+        // reactors run until the process exits
+        std::thread(&TcpServer::run, reactors[i].get(),
+            portNumber, handlers).detach();
+    }
+    pthread_sigmask(SIG_SETMASK, &previousSignals, nullptr);
+
+    reactors[0]->run(portNumber, handlers);
+}
+
+ServerConfig ReactorPool::getReactorConfig(const ServerConfig &config)
+{
+    uint32_t reactorCount = std::max(config.reactors, 1u);
+    ServerConfig reactorConfig = config;
+    reactorConfig.maxConnections
+        = (config.maxConnections + reactorCount - 1) / reactorCount;
+    return reactorConfig;
+}
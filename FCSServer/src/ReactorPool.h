@@ -0,0 +1,69 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef REACTORPOOL_H
+#define REACTORPOOL_H
+
+#include "Drain.h"
+#include "RequestExecutor.h"
+#include "ServerConfig.h"
+#include "TcpServer.h"
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+/*
+Runs config.reactors TcpServer reactors, each on its own thread with its own
+SO_REUSEPORT listener and connection table, so parsing and logging spread
+over the cores. All reactors hand requests to one shared RequestExecutor.
+*/
+class ReactorPool
+{
+    public:
+        void setConfig(const ServerConfig &serverConfig)
+        {
+            config = serverConfig;
+        }
+        // runs first reactor on calling thread, never returns
+        void run(uint32_t portNumber, const MessageHandlers &handlers);
+        // config of each reactor, the connection limit is split between them
+        static ServerConfig getReactorConfig(const ServerConfig &config);
+
+    private:
+        ServerConfig config;
+        std::unique_ptr<RequestExecutor> executor;
+        Drain drain;
+        std::vector<std::unique_ptr<TcpServer>> reactors;
+};
+
+#endif /* REACTORPOOL_H */
@@ -0,0 +1,192 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "Logger.h"
+#include "RequestExecutor.h"
+#include "Statistics.h"
+
+#include <signal.h>
+
+RequestExecutor::RequestExecutor(
+    const MessageHandlers &messageHandlers,
+    uint32_t numberOfWorkers)
+    : handlers(messageHandlers), workerCount(numberOfWorkers)
+{
+}
+
+RequestExecutor::~RequestExecutor()
+{
+    stop();
+}
+
+bool RequestExecutor::start()
+{
+    // workers inherit the mask, so termination signals reach the main thread
+    sigset_t blockedSignals;
+    sigset_t previousSignals;
+    sigfillset(&blockedSignals);
+    pthread_sigmask(SIG_BLOCK, &blockedSignals, &previousSignals);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&RequestExecutor::workerLoop, this);
+    }
+    pthread_sigmask(SIG_SETMASK, &previousSignals, nullptr);
+    Logger::log("Started " + std::to_string(workerCount)
+        + " request worker(s)", Debug);
+    return true;
+}
+
+void RequestExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        stopping = true;
+    }
+    requestsCondition.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void RequestExecutor::submit(
+    CompletionQueue &completionQueue,
+    uint64_t connectionToken,
+    uint8_t requestId,
+    BufferView message)
+{
+    Clock::time_point now = Clock::now();
+    Admission admission;
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        admission = admit(QueuedRequest { &completionQueue,
+            connectionToken, requestId, message, now }, now);
+        // gauge is updated under the lock, so updates land in order
+        Statistics::set(Statistics::executorQueueDepth, requests.size());
+        Statistics::setMax(Statistics::executorQueueDepthMax, requests.size());
+    }
+    if (admission == admitted)
+    {
+        Statistics::increment(Statistics::executorRequestsAccepted);
+        requestsCondition.notify_one();
+        return;
+    }
+
+    // answered right away instead of waiting in socket buffers
+    // until the client gives up
+    Completion completion { connectionToken, requestId, {} };
+    if (admission == clientOverRate)
+    {
+        Statistics::increment(Statistics::executorRequestsRejectedBusy);
+        handlers.onBusy(message, completion.response);
+    }
+    else
+    {
+        Statistics::increment(admission == tooManyPending
+            ? Statistics::executorRequestsShedPending
+            : Statistics::executorRequestsShedServiceTime);
+        handlers.onRetryLater(message, completion.response);
+    }
+    completionQueue.push(std::move(completion));
+}
+
+RequestExecutor::Admission RequestExecutor::admit(
+    QueuedRequest &&request, Clock::time_point now)
+{
+    // shed before the client's rate is charged for the request
+    uint32_t pendingRequests = requests.size() + requestsInService;
+    if (shedPendingRequests > 0 && pendingRequests >= shedPendingRequests)
+    {
+        return tooManyPending;
+    }
+    // slow service alone is no reason to shed while a worker is free,
+    // which also lets the average recover once load goes away
+    if (shedServiceTimeInMicroseconds > 0
+        && pendingRequests >= workerCount
+        && recentServiceTimeInMicroseconds >= shedServiceTimeInMicroseconds)
+    {
+        return serviceTooSlow;
+    }
+    return requests.push(std::move(request), now) ? admitted : clientOverRate;
+}
+
+void RequestExecutor::workerLoop()
+{
+    while (true)
+    {
+        QueuedRequest request;
+        {
+            std::unique_lock<std::mutex> lock(requestsMutex);
+            requestsCondition.wait(lock, [this]
+            {
+                return stopping || requests.size() > 0;
+            });
+            if (stopping)
+            {
+                return;
+            }
+            requests.pop(request);
+            requestsInService++;
+            Statistics::set(Statistics::executorQueueDepth, requests.size());
+        }
+        Clock::time_point startTime = Clock::now();
+        uint64_t waitTimeInMicroseconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                startTime - request.submitTime).count();
+        Statistics::increment(
+            Statistics::executorWaitTimeTotalUs, waitTimeInMicroseconds);
+        Statistics::setMax(Statistics::executorWaitTimeMaxUs, waitTimeInMicroseconds);
+
+        Completion completion {
+            request.connectionToken, request.requestId, {} };
+        handlers.onMessage(
+            request.message, completion.response, request.connectionToken);
+
+        uint64_t serviceTimeInMicroseconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - startTime).count();
+        Statistics::increment(Statistics::executorRequests);
+        Statistics::increment(Statistics::executorServiceTimeTotalUs,
+            serviceTimeInMicroseconds);
+        {
+            std::lock_guard<std::mutex> lock(requestsMutex);
+            requests.recordServiceTime(
+                request.commandCode, serviceTimeInMicroseconds);
+            recentServiceTimeInMicroseconds =
+                (recentServiceTimeInMicroseconds * 7
+                    + serviceTimeInMicroseconds) / 8;
+            requestsInService--;
+        }
+        request.completionQueue->push(std::move(completion));
+    }
+}
@@ -0,0 +1,143 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef REQUESTEXECUTOR_H
+#define REQUESTEXECUTOR_H
+
+#include "BufferView.h"
+#include "CompletionQueue.h"
+#include "FairQueue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+typedef void (*MessageCallback)(BufferView, ResponseMessage&);
+// connectionToken tells apart the connections requests come from
+typedef void (*RequestCallback)(
+    BufferView, ResponseMessage&, uint64_t connectionToken);
+typedef void (*ConnectionCallback)(uint64_t connectionToken);
+typedef bool (*ConnectionQuery)(uint64_t connectionToken);
+typedef void (*ShutdownCallback)();
+
+// protocol specific answers, the executor only picks one
+struct MessageHandlers
+{
+    RequestCallback onMessage;
+    // client is over its request rate
+    MessageCallback onBusy;
+    // server is overloaded, client should retry later
+    MessageCallback onRetryLater;
+    // connection is closed and none of its requests is in flight,
+    // e.g. to release what the client held; called on its reactor
+    ConnectionCallback onConnectionClosed;
+    // connection holds state only this process knows, so it is not
+    // handed over in a hot restart; called on its reactor
+    ConnectionQuery holdsConnectionState;
+    // process terminates right after, once the last reactor finished
+    // draining or on a second stop signal
+    ShutdownCallback onShutdown;
+};
+
+/*
+Runs message handling (and so FCS ioctls) on worker threads, so a slow
+mailbox round trip does not block the network threads. Shared by all
+reactors, each request carries the CompletionQueue its response goes to.
+*/
+class RequestExecutor
+{
+    public:
+        RequestExecutor(
+            const MessageHandlers &messageHandlers,
+            uint32_t numberOfWorkers);
+        ~RequestExecutor();
+
+        // per connection, 0 requests per second disables the limit
+        void setRateLimit(uint32_t requestsPerSecond, uint32_t burst)
+        {
+            requests.setRateLimit(requestsPerSecond, burst);
+        }
+        // requests are shed when this many are queued or in service, or
+        // when all workers are busy and recent service time is this long;
+        // 0 disables either check
+        void setLoadShedding(
+            uint32_t maxPendingRequests, uint32_t maxServiceTimeInMilliseconds)
+        {
+            shedPendingRequests = maxPendingRequests;
+            shedServiceTimeInMicroseconds =
+                uint64_t(maxServiceTimeInMilliseconds) * 1000;
+        }
+        bool start();
+        void stop();
+        // message is not copied, caller keeps it alive until completion
+        void submit(
+            CompletionQueue &completionQueue,
+            uint64_t connectionToken,
+            uint8_t requestId,
+            BufferView message);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        enum Admission
+        {
+            admitted,
+            clientOverRate,
+            tooManyPending,
+            serviceTooSlow
+        };
+
+        Admission admit(QueuedRequest &&request, Clock::time_point now);
+        void workerLoop();
+
+        MessageHandlers handlers;
+        uint32_t workerCount;
+        std::vector<std::thread> workers;
+
+        std::mutex requestsMutex;
+        std::condition_variable requestsCondition;
+        FairQueue requests;
+        // requests taken by workers and not completed yet
+        uint32_t requestsInService = 0;
+        // moving average over all commands
+        uint64_t recentServiceTimeInMicroseconds = 0;
+        uint32_t shedPendingRequests = 0;
+        uint64_t shedServiceTimeInMicroseconds = 0;
+        bool stopping = false;
+};
+
+#endif /* REQUESTEXECUTOR_H */
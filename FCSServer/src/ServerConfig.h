@@ -0,0 +1,101 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef SERVERCONFIG_H
+#define SERVERCONFIG_H
+
+#include "Poller.h"
+
+#include <stdint.h>
+#include <string>
+#include <sys/socket.h>
+
+struct ServerConfig
+{
+    PollerBackend pollerBackend = epollBackend;
+    // connection without any request for this long is dropped, 0 disables
+    uint32_t idleTimeoutInSeconds = 60;
+    // connections above this limit are accepted and closed right away,
+    // split evenly between reactors
+    uint32_t maxConnections = 20;
+    // pending connections kernel queues before they are accepted
+    uint32_t listenBacklog = SOMAXCONN;
+    // local clients may also connect here, empty disables
+    std::string unixSocketPath;
+    uint32_t unixSocketMode = 0660;
+    // network threads, each with its own listener and connections
+    uint32_t reactors = 1;
+    // threads handling requests, 0 handles them on the network thread
+    uint32_t workers = 1;
+    // /dev/fcs descriptors kept open, 0 keeps one per worker
+    uint32_t deviceHandles = 0;
+    // chip ID, ID code, device identity and certificates are answered
+    // from memory after the first call
+    bool responseCache = true;
+    // age of cached responses, 0 keeps them until the certificate is
+    // reloaded or the device is reset
+    uint32_t responseCacheTtlInSeconds = 0;
+    // SDM crypto service sessions lent to clients, 0 disables
+    uint32_t cryptoSessions = 0;
+    // requests of one connection handled at once, above 1 responses are
+    // sent as they complete and clients match them by CommandHeader.id
+    uint32_t pipelineDepth = 1;
+    // requests per second of each connection, whatever CommandHeader.client
+    // it uses; more get a busy response, 0 disables. Needs workers.
+    uint32_t clientRequestRate = 0;
+    // requests a client may send in a burst, 0 means the rate
+    uint32_t clientRequestBurst = 0;
+    // load shedding, requests get a retry later response when this many
+    // are queued or in service, 0 disables. Needs workers.
+    uint32_t shedPendingRequests = 0;
+    // or when all workers are busy and recent service time is this long
+    uint32_t shedServiceTimeInMilliseconds = 0;
+    // listening sockets passed by systemd or by the previous process
+    // of a hot restart, -1 creates them from the port and unixSocketPath
+    int inheritedServerSocketFd = -1;
+    int inheritedUnixSocketFd = -1;
+    // file of the inherited unix socket is removed on exit, i.e. it came
+    // from the previous process rather than from systemd
+    bool ownsInheritedUnixSocketFile = false;
+    // on SIGTERM, requests still in flight after this long are abandoned,
+    // also bounds the old process of a hot restart; 0 waits indefinitely
+    uint32_t drainTimeoutInSeconds = 30;
+    // control socket of hot restart, empty disables
+    std::string handoffSocketPath;
+    // HandoffChannel to the process being taken over from, which keeps
+    // sending it connections; -1 when started afresh
+    int previousProcessFd = -1;
+    // period of statistics log lines, 0 disables
+    uint32_t statisticsIntervalInSeconds = 0;
+};
+
+#endif /* SERVERCONFIG_H */
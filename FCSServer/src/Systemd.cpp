@@ -0,0 +1,125 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "Logger.h"
+#include "Systemd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+std::vector<int> Systemd::takeListenFds()
+{
+    std::vector<int> fds;
+    const char *listenFds = getenv("LISTEN_FDS");
+    if (listenFds != nullptr && isForThisProcess("LISTEN_PID"))
+    {
+        int count = atoi(listenFds);
+        for (int fd = kListenFdsStart; fd < kListenFdsStart + count; fd++)
+        {
+            // accept loop relies on EAGAIN to end
+            int flags = fcntl(fd, F_GETFL);
+            if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1
+                || fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+            {
+                Logger::logWithReturnCode("Passed socket "
+                    + std::to_string(fd) + " unusable.", errno, Error);
+                continue;
+            }
+            fds.push_back(fd);
+        }
+    }
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDNAMES");
+    return fds;
+}
+
+bool Systemd::notify(const std::string &state)
+{
+    const char *socketPath = getenv("NOTIFY_SOCKET");
+    if (socketPath == nullptr || socketPath[0] == '\0')
+    {
+        return false;
+    }
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::string path(socketPath);
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    path.copy(address.sun_path, path.size());
+    // leading '@' stands for the abstract namespace
+    if (address.sun_path[0] == '@')
+    {
+        address.sun_path[0] = '\0';
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        return false;
+    }
+    socklen_t addressSize = offsetof(sockaddr_un, sun_path) + path.size();
+    ssize_t sentSize = sendto(fd, state.data(), state.size(), MSG_NOSIGNAL,
+        (sockaddr*)&address, addressSize);
+    close(fd);
+    if (sentSize == -1)
+    {
+        Logger::logWithReturnCode("Notifying systemd failed.", errno, Error);
+        return false;
+    }
+    return true;
+}
+
+uint64_t Systemd::getWatchdogIntervalInMicroseconds()
+{
+    const char *watchdogUsec = getenv("WATCHDOG_USEC");
+    // WATCHDOG_PID is optional, it only narrows down the process
+    if (watchdogUsec == nullptr
+        || (getenv("WATCHDOG_PID") != nullptr && !isForThisProcess("WATCHDOG_PID")))
+    {
+        return 0;
+    }
+    return strtoull(watchdogUsec, nullptr, 10);
+}
+
+bool Systemd::isForThisProcess(const char *pidVariable)
+{
+    const char *pid = getenv(pidVariable);
+    return pid != nullptr && atol(pid) == static_cast<long>(getpid());
+}
@@ -0,0 +1,64 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef SYSTEMD_H
+#define SYSTEMD_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+The parts of the systemd service protocol the server uses, implemented
+directly so libsystemd is not needed on the HPS image:
+- socket activation, listening sockets passed in LISTEN_FDS
+- sd_notify style state messages to NOTIFY_SOCKET
+Everything is a no-op when not started by systemd.
+*/
+class Systemd
+{
+    public:
+        // passed listening sockets, made non-blocking; environment is
+        // cleared so child processes do not take them as well
+        static std::vector<int> takeListenFds();
+        // e.g. "READY=1", false when not running under systemd
+        static bool notify(const std::string &state);
+        // interval the watchdog expects WATCHDOG=1 at, 0 when disabled
+        static uint64_t getWatchdogIntervalInMicroseconds();
+
+    private:
+        static bool isForThisProcess(const char *pidVariable);
+        // first file descriptor passed by systemd
+        static const int kListenFdsStart = 3;
+};
+
+#endif /* SYSTEMD_H */
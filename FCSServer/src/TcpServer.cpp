@@ -30,61 +30,197 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************
 */
 
+#include "CommandHeader.h"
 #include "Logger.h"
+#include "Statistics.h"
+#include "Systemd.h"
 #include "TcpServer.h"
 
 #include <arpa/inet.h>
-#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 
-void TcpServer::run(
-    uint32_t portNumber,
-    void (*onMessage)(std::vector<uint8_t>&, std::vector<uint8_t>&))
+TcpServer::~TcpServer()
 {
-    setup(portNumber);
-    Logger::log("Server started on port " + std::to_string(portNumber));
-
-    while (true)
+    // only a server driven by runOnce gets here, run never returns
+    connections.forEach([](Connection &connection)
     {
-        for (unsigned int i = 1; i < kNumberOfSockets; i++)
-        {
-            sockets[i].events = POLLIN;
-            sockets[i].revents = 0;
-        }
-        int numberOfEvents = poll(
-            sockets, kNumberOfSockets, kPollTimeoutInMilliseconds);
-        if (numberOfEvents < 0)
-        {
-            Logger::logWithReturnCode("Poll failed.", errno, Error);
-            exit(1);
-        }
-        else if (numberOfEvents == 0)
+        close(connection.fd);
+    });
+    // a passed listener may still be used by other reactors
+    if (serverSocketFd != -1 && config.inheritedServerSocketFd == -1)
+    {
+        close(serverSocketFd);
+    }
+    for (int fd : { unixSocketFd, signalFd, handoffListenerFd })
+    {
+        if (fd != -1)
         {
-            dropUnusedConnections();
-            continue;
+            close(fd);
         }
-        for (unsigned int i = 0; i < kNumberOfSockets; i++)
+    }
+}
+
+void TcpServer::run(uint32_t portNumber, const MessageHandlers &handlers)
+{
+    start(portNumber, handlers);
+    while (runOnce(-1))
+    {
+    }
+    if (shutdownCallback != nullptr)
+    {
+        shutdownCallback();
+    }
+    // other reactors are idle and workers idle or abandoned,
+    // destructors would run underneath them
+    _exit(0);
+}
+
+void TcpServer::start(uint32_t portNumber, const MessageHandlers &handlers)
+{
+    messageCallback = handlers.onMessage;
+    connectionClosedCallback = handlers.onConnectionClosed;
+    connectionStateQuery = handlers.holdsConnectionState;
+    shutdownCallback = handlers.onShutdown;
+    setup(portNumber);
+    std::string reactorName = config.reactors > 1
+        ? ", reactor " + std::to_string(reactorIndex) : "";
+    std::string listener = config.inheritedServerSocketFd != -1
+        ? "passed socket" : "port " + std::to_string(portNumber);
+    Logger::log("Server started on " + listener
+        + " using " + poller->getName() + " backend" + reactorName);
+    if (reactorIndex == 0)
+    {
+        // after a hot restart this process is the one to supervise
+        std::string mainPid = previousProcess != nullptr
+            ? "MAINPID=" + std::to_string(getpid()) + "\n" : "";
+        Systemd::notify(mainPid + "READY=1");
+    }
+}
+
+bool TcpServer::runOnce(int maxWaitInMilliseconds)
+{
+    int timeout = timers.getTimeoutInMilliseconds(TimerQueue::Clock::now());
+    if (maxWaitInMilliseconds >= 0
+        && (timeout < 0 || timeout > maxWaitInMilliseconds))
+    {
+        timeout = maxWaitInMilliseconds;
+    }
+    int numberOfEvents = poller->wait(readyEvents, timeout);
+    if (numberOfEvents < 0)
+    {
+        // e.g. SIGSTOP and SIGCONT, or a debugger attaching
+        if (errno == EINTR)
         {
-            if (sockets[i].fd != -1)
-            {
-                handleEventIfAny(sockets[i], onMessage);
-            }
+            return true;
         }
+        Logger::logWithReturnCode("Poll failed.", errno, Error);
+        exit(1);
+    }
+    for (const PollerEvent &event : readyEvents)
+    {
+        handleEvent(event);
     }
+    handleExpiredTimers();
+    if (draining)
+    {
+        finishDrainIfDone();
+    }
+    return !processFinished;
 }
 
 void TcpServer::setup(uint32_t portNumber)
 {
     Logger::log("Setting up TCP server...", Debug);
-    serverSocketFd = socket(AF_INET, SOCK_STREAM | O_NONBLOCK, 0);
+    if (config.inheritedServerSocketFd != -1)
+    {
+        // kept by the service manager or the previous process across
+        // restarts, so connections queue in its backlog; reactors share it
+        serverSocketFd = config.inheritedServerSocketFd;
+        Logger::log("Using passed listening socket", Debug);
+    }
+    else
+    {
+        setupServerSocket(portNumber);
+    }
+
+    connections.setLimit(config.maxConnections);
+    poller = Poller::create(config.pollerBackend);
+    if (!poller->add(serverSocketFd, readableEvent, kServerSocketToken))
+    {
+        Logger::logWithReturnCode("Poller registration failed.", errno, Fatal);
+        exit(1);
+    }
+    // unix sockets cannot be shared between reactors by the kernel
+    if (config.inheritedUnixSocketFd != -1 && reactorIndex == 0)
+    {
+        unixSocketFd = config.inheritedUnixSocketFd;
+        ownsUnixSocketFile = config.ownsInheritedUnixSocketFile;
+        registerUnixSocket();
+    }
+    else if (!config.unixSocketPath.empty() && reactorIndex == 0)
+    {
+        setupUnixSocket();
+    }
+
+    if (drain != nullptr)
+    {
+        setupDrain();
+    }
+
+    if (executor != nullptr
+        && (!completionQueue.open()
+            || !poller->add(completionQueue.getNotificationFd(),
+                readableEvent, kCompletionToken)))
+    {
+        Logger::logWithReturnCode(
+            "Completion queue setup failed.", errno, Fatal);
+        exit(1);
+    }
+    // statistics are process wide, one reactor logs them
+    if (config.statisticsIntervalInSeconds > 0 && reactorIndex == 0)
+    {
+        timers.schedule(kStatisticsTimerId, TimerQueue::Clock::now()
+            + std::chrono::seconds(config.statisticsIntervalInSeconds));
+    }
+    // pinged from the event loop, so a stuck loop gets the service restarted
+    if (reactorIndex == 0)
+    {
+        watchdogInterval = std::chrono::microseconds(
+            Systemd::getWatchdogIntervalInMicroseconds() / 2);
+        if (watchdogInterval.count() > 0)
+        {
+            timers.schedule(kWatchdogTimerId,
+                TimerQueue::Clock::now() + watchdogInterval);
+        }
+    }
+}
+
+void TcpServer::setupServerSocket(uint32_t portNumber)
+{
+    serverSocketFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (serverSocketFd == -1)
     {
         Logger::logWithReturnCode("Could not create socket.", errno, Fatal);
         exit(1);
     }
 
+    // every reactor binds its own listener, kernel spreads connections
+    int reusePort = 1;
+    if (config.reactors > 1 && setsockopt(serverSocketFd, SOL_SOCKET,
+        SO_REUSEPORT, &reusePort, sizeof(reusePort)) == -1)
+    {
+        Logger::logWithReturnCode("Setting SO_REUSEPORT failed.", errno, Fatal);
+        exit(1);
+    }
+
     sockaddr_in server;
     server.sin_family = AF_INET;
     server.sin_addr.s_addr = INADDR_ANY;
@@ -100,123 +236,927 @@ void TcpServer::setup(uint32_t portNumber)
         exit(1);
     }
 
-    if (listen(serverSocketFd, kMaxNumberOfConnections) == -1)
+    if (listen(serverSocketFd, config.listenBacklog) == -1)
     {
         Logger::logWithReturnCode("Listen failed.", errno, Fatal);
         exit(1);
     }
+}
+
+void TcpServer::setupUnixSocket()
+{
+    const std::string &path = config.unixSocketPath;
+    sockaddr_un server = {};
+    server.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(server.sun_path))
+    {
+        Logger::log("Unix socket path too long: " + path, Fatal);
+        exit(1);
+    }
+    path.copy(server.sun_path, path.size());
+
+    unixSocketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (unixSocketFd == -1)
+    {
+        Logger::logWithReturnCode("Could not create unix socket.", errno, Fatal);
+        exit(1);
+    }
+    // socket file left behind by a previous run would make bind fail,
+    // anything else at the path is kept
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+    {
+        unlink(path.c_str());
+    }
+    // created inaccessible and opened up by chmod, so no client
+    // can connect before permissions are applied
+    mode_t previousMask = umask(0777);
+    int bindResult = bind(unixSocketFd, (sockaddr*)&server, sizeof(server));
+    umask(previousMask);
+    if (bindResult < 0)
+    {
+        Logger::logWithReturnCode("Unix socket bind failed.", errno, Fatal);
+        exit(1);
+    }
+    if (chmod(path.c_str(), config.unixSocketMode) == -1)
+    {
+        Logger::logWithReturnCode("Unix socket chmod failed.", errno, Fatal);
+        exit(1);
+    }
+    if (listen(unixSocketFd, config.listenBacklog) == -1)
+    {
+        Logger::logWithReturnCode("Unix socket listen failed.", errno, Fatal);
+        exit(1);
+    }
+    ownsUnixSocketFile = true;
+    registerUnixSocket();
+    Logger::log("Listening on unix socket " + path);
+}
 
-    sockets[0].fd = serverSocketFd;
-    sockets[0].events = POLLIN;
-    for (unsigned int i = 1; i < kNumberOfSockets; i++)
+void TcpServer::registerUnixSocket()
+{
+    if (!poller->add(unixSocketFd, readableEvent, kUnixSocketToken))
     {
-        sockets[i].fd = -1;
+        Logger::logWithReturnCode("Poller registration failed.", errno, Fatal);
+        exit(1);
     }
 }
 
-void TcpServer::closeSockets()
+void TcpServer::setupHandoffListener()
 {
-    for (unsigned int i = 1; i < kNumberOfSockets; i++)
+    handoffListenerFd = HandoffChannel::listen(config.handoffSocketPath);
+    if (handoffListenerFd == -1)
+    {
+        // clients are still served, only the next hot restart fails
+        return;
+    }
+    if (!poller->add(handoffListenerFd, readableEvent, kHandoffListenerToken))
     {
-        if (sockets[i].fd != -1)
+        Logger::logWithReturnCode("Poller registration failed.", errno, Error);
+        close(handoffListenerFd);
+        handoffListenerFd = -1;
+    }
+}
+
+void TcpServer::setupDrain()
+{
+    if (!poller->add(drain->getNotificationFd(reactorIndex),
+        readableEvent, kDrainStartToken))
+    {
+        Logger::logWithReturnCode("Poller registration failed.", errno, Fatal);
+        exit(1);
+    }
+    if (reactorIndex == 0)
+    {
+        setupSignalFd();
+    }
+    if (reactorIndex == 0 && config.previousProcessFd != -1)
+    {
+        // control socket is taken over once the previous process is gone
+        previousProcess =
+            std::make_unique<HandoffChannel>(config.previousProcessFd);
+        if (!poller->add(config.previousProcessFd,
+            readableEvent, kPreviousProcessToken))
+        {
+            Logger::logWithReturnCode("Poller registration failed.", errno, Fatal);
+            exit(1);
+        }
+    }
+    else if (reactorIndex == 0 && !config.handoffSocketPath.empty())
+    {
+        setupHandoffListener();
+    }
+}
+
+void TcpServer::setupSignalFd()
+{
+    // other threads block all signals, so they are only delivered here,
+    // and a response being prepared is never cut off by a handler
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+    signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd == -1
+        || !poller->add(signalFd, readableEvent, kSignalToken))
+    {
+        Logger::logWithReturnCode("Signal handling setup failed.", errno, Fatal);
+        exit(1);
+    }
+}
+
+void TcpServer::handleSignals()
+{
+    signalfd_siginfo signalInfo;
+    while (read(signalFd, &signalInfo, sizeof(signalInfo))
+        == sizeof(signalInfo))
+    {
+        if (drain->isStarted())
+        {
+            Logger::log("Signal caught again, terminating");
+            if (shutdownCallback != nullptr)
+            {
+                shutdownCallback();
+            }
+            _exit(0);
+        }
+        Logger::log("Signal caught, finishing requests before terminating");
+        Systemd::notify("STOPPING=1");
+        drain->start(nullptr);
+    }
+}
+
+void TcpServer::handleExpiredTimers()
+{
+    TimerQueue::Clock::time_point now = TimerQueue::Clock::now();
+    uint64_t timerId;
+    while (timers.popExpired(now, timerId))
+    {
+        if (timerId == kStatisticsTimerId)
+        {
+            logStatistics();
+            timers.schedule(kStatisticsTimerId, now
+                + std::chrono::seconds(config.statisticsIntervalInSeconds));
+            continue;
+        }
+        if (timerId == kWatchdogTimerId)
+        {
+            Systemd::notify("WATCHDOG=1");
+            timers.schedule(kWatchdogTimerId, now + watchdogInterval);
+            continue;
+        }
+        if (timerId == kDrainTimerId)
         {
-            close(sockets[i].fd);
+            handleDrainTimeout();
+            continue;
         }
+        dropIdleConnection(timerId, now);
+    }
+}
+
+void TcpServer::dropIdleConnection(
+    uint64_t token, TimerQueue::Clock::time_point now)
+{
+    Connection *connection = connections.find(token);
+    if (connection == nullptr)
+    {
+        return;
+    }
+    // activity only refreshes lastActivity, the timer is moved lazily here;
+    // a request still being handled by a worker counts as activity
+    TimerQueue::Clock::time_point deadline = connection->lastActivity
+        + std::chrono::seconds(config.idleTimeoutInSeconds);
+    if (deadline <= now && connection->requestsInFlight > 0)
+    {
+        deadline = now + std::chrono::seconds(config.idleTimeoutInSeconds);
+    }
+    if (deadline > now)
+    {
+        timers.schedule(token, deadline);
+        return;
     }
-    close(serverSocketFd);
+    Logger::log("Dropping unused connection: Socket fd: "
+        + std::to_string(connection->fd), Debug);
+    closeConnectionAndEnableForReuse(*connection);
+}
+
+void TcpServer::logStatistics()
+{
+    Logger::log("Statistics: " + Statistics::toString());
 }
 
-void TcpServer::dropUnusedConnections()
+void TcpServer::handleEvent(const PollerEvent &event)
 {
-    for (unsigned int i = 1; i < kNumberOfSockets; i++)
+    if (event.token == kServerSocketToken
+        || event.token == kUnixSocketToken)
     {
-        if (sockets[i].fd != -1)
+        if (event.events & errorEvent)
         {
-            Logger::log("Dropping unused connection: Socket fd: "
-                + std::to_string(i), Debug);
-            closeConnectionAndEnableForReuse(sockets[i]);
+            // no connection would ever be accepted again
+            Logger::log("Listening socket cannot be polled", Fatal);
+            exit(1);
+        }
+        if (event.events & readableEvent)
+        {
+            acceptConnections(event.token == kServerSocketToken
+                ? serverSocketFd : unixSocketFd);
         }
+        return;
+    }
+    if (event.token == kCompletionToken)
+    {
+        handleCompletions();
+        return;
+    }
+    if (event.token == kHandoffListenerToken)
+    {
+        acceptNewProcess();
+        return;
+    }
+    if (event.token == kDrainStartToken)
+    {
+        beginDrain();
+        return;
+    }
+    if (event.token == kSignalToken)
+    {
+        handleSignals();
+        return;
+    }
+    if (event.token == kPreviousProcessToken)
+    {
+        receiveFromPreviousProcess();
+        return;
+    }
+    Connection *connection = connections.find(event.token);
+    if (connection == nullptr)
+    {
+        return;
+    }
+    if ((event.events & writableEvent) && flushOutput(*connection))
+    {
+        // reads may have been paused on a full output queue
+        dispatchFrames(*connection);
+    }
+    if (connection->fd != -1 && (event.events & readableEvent))
+    {
+        readFromConnection(*connection);
+    }
+    if (connection->fd != -1
+        && (event.events & (hangupEvent | errorEvent)))
+    {
+        closeConnectionAndEnableForReuse(*connection);
+    }
+    releaseIfIdle(*connection);
+    if (connection->fd != -1)
+    {
+        updateRegisteredEvents(*connection);
     }
 }
 
-void TcpServer::handleEventIfAny(
-    pollfd &socket,
-    void (*onMessage)(std::vector<uint8_t>&, std::vector<uint8_t>&))
+void TcpServer::handleCompletions()
 {
-    if (socket.fd == serverSocketFd && socket.revents == POLLIN)
+    completionQueue.take(completions);
+    for (Completion &completion : completions)
     {
-        acceptConnection();
+        // connection may have been closed while its request was handled
+        Connection *connection = connections.find(completion.connectionToken);
+        if (connection == nullptr)
+        {
+            releaseOrphanedRequest(completion.connectionToken);
+            Statistics::increment(Statistics::executorResponsesDropped);
+            continue;
+        }
+        if (isPipelined())
+        {
+            connection->idsInFlight &= ~(1 << completion.requestId);
+        }
+        else
+        {
+            connection->framer.consumeFrame();
+        }
+        connection->requestsInFlight--;
+        completeMessage(*connection, completion.response);
+        // next request of this connection may already be buffered
+        dispatchFrames(*connection);
+        releaseIfIdle(*connection);
+        if (connection->fd != -1)
+        {
+            updateRegisteredEvents(*connection);
+        }
     }
-    else if (socket.revents == POLLIN)
+}
+
+void TcpServer::readFromConnection(Connection &connection)
+{
+    // Client sockets are non-blocking and may be edge triggered,
+    // so keep reading until the kernel buffer is drained
+    while (connection.fd != -1 && isReadingAllowed(connection))
     {
-        messageBuffer.resize(kMaxMessageSizeInBytes);
-        ssize_t messageSize = recv(
-            socket.fd, messageBuffer.data(), messageBuffer.size(), 0);
-        if (messageSize == -1)
+        ssize_t receivedSize = recv(connection.fd,
+            connection.framer.getWritePointer(kMaxMessageSizeInBytes),
+            kMaxMessageSizeInBytes, 0);
+        if (receivedSize == -1)
         {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
             Logger::logWithReturnCode("Recv failed", errno, Error);
-            closeConnectionAndEnableForReuse(socket);
+            closeConnectionAndEnableForReuse(connection);
         }
-        else if (messageSize == 0)
+        else if (receivedSize == 0)
         {
-            closeConnectionAndEnableForReuse(socket);
+            closeConnectionAndEnableForReuse(connection);
         }
-        else if (messageSize > 0)
+        else if (receivedSize > 0)
         {
-            messageBuffer.resize(messageSize);
-            Logger::log("Received message: Socket fd: "
-                + std::to_string(socket.fd), Info);
-            std::vector<uint8_t> responseBuffer;
+            connection.framer.commitWrite(receivedSize);
+            if (connection.discardInput)
+            {
+                connection.framer.reset();
+                continue;
+            }
+            connection.lastActivity = TimerQueue::Clock::now();
+            dispatchFrames(connection);
+        }
+    }
+}
+
+void TcpServer::dispatchFrames(Connection &connection)
+{
+    // a single read may carry several pipelined requests
+    BufferView message;
+    while (connection.fd != -1
+        && isDispatchAllowed(connection)
+        && connection.framer.peekFrame(message))
+    {
+        if (isPipelined())
+        {
+            // a reused id waits for the earlier request with it to complete
+            CommandHeader header;
+            header.parse(message);
+            if (connection.idsInFlight & (1 << header.id))
+            {
+                return;
+            }
+            handlePipelinedMessage(connection, message, header.id);
+            continue;
+        }
+        handleMessage(connection, message);
+    }
+}
 
-            onMessage(messageBuffer, responseBuffer);
+void TcpServer::handlePipelinedMessage(
+    Connection &connection, BufferView message, uint8_t requestId)
+{
+    Logger::log("Received pipelined message: Socket fd: "
+        + std::to_string(connection.fd)
+        + ", id: " + std::to_string(requestId), Debug);
+    // requests complete out of order, so each one is copied out of the
+    // framer; the copy reuses the capacity left by earlier requests
+    std::vector<uint8_t> &request = connection.pipelinedRequests[requestId];
+    request.assign(message.data(), message.data() + message.size());
+    connection.framer.consumeFrame();
+    connection.idsInFlight |= 1 << requestId;
+    connection.requestsInFlight++;
+    executor->submit(completionQueue, connection.token, requestId, request);
+}
+
+void TcpServer::handleMessage(Connection &connection, BufferView message)
+{
+    Logger::log("Received message: Socket fd: "
+        + std::to_string(connection.fd), Debug);
+    if (executor != nullptr)
+    {
+        // message stays in the framer until completion and reading pauses
+        // meanwhile, so the worker reads the receive buffer without a copy;
+        // one request per connection at a time also keeps responses in order
+        connection.requestsInFlight++;
+        executor->submit(completionQueue, connection.token, 0, message);
+        return;
+    }
+
+    ResponseMessage response;
+    messageCallback(message, response, connection.token);
+    connection.framer.consumeFrame();
+    completeMessage(connection, response);
+}
+
+void TcpServer::completeMessage(
+    Connection &connection, ResponseMessage &response)
+{
+    if (!response.empty())
+    {
+        Logger::log("Sending Response: "
+            + std::to_string(response.size()) + " bytes", Debug);
+        connection.pendingOutputBytes += response.size();
+        connection.outputQueue.push_back(std::move(response));
+        if (flushOutput(connection)
+            && connection.pendingOutputBytes >= kOutputHighWaterMarkInBytes)
+        {
+            Logger::log("Responses not drained, pausing reads: Socket fd: "
+                + std::to_string(connection.fd), Debug);
+        }
+    }
+    else
+    {
+        Logger::log("No data to send. Closing connection", Debug);
+        connection.closeAfterFlush = true;
+        flushOutput(connection);
+    }
+}
 
-            if (responseBuffer.size() > 0)
+bool TcpServer::flushOutput(Connection &connection)
+{
+    while (!connection.outputQueue.empty())
+    {
+        // header and payload of queued responses go out in one call
+        iovec iovecs[kMaxIovecsPerSend];
+        msghdr message = {};
+        message.msg_iov = iovecs;
+        size_t offset = connection.outputOffset;
+        for (const ResponseMessage &response : connection.outputQueue)
+        {
+            if (message.msg_iovlen + ResponseMessage::kMaxIovecs
+                > kMaxIovecsPerSend)
+            {
+                break;
+            }
+            message.msg_iovlen += response.getIovecs(
+                offset, iovecs + message.msg_iovlen);
+            offset = 0;
+        }
+        ssize_t sentSize = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (sentSize == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
             {
-                Logger::log("Sending Response: "
-                    + std::to_string(responseBuffer.size()) + " bytes", Info);
-                if (send(socket.fd, responseBuffer.data(), responseBuffer.size(), 0) == -1)
-                {
-                    Logger::logWithReturnCode("Send failed", errno, Error);
-                }
+                return true;
             }
-            else
+            if (errno == EINTR)
             {
-                Logger::log("No data to send. Closing connection", Info);
-                closeConnectionAndEnableForReuse(socket);
+                continue;
             }
+            Logger::logWithReturnCode("Send failed", errno, Error);
+            closeConnectionAndEnableForReuse(connection);
+            return false;
         }
+        connection.pendingOutputBytes -= sentSize;
+        connection.lastActivity = TimerQueue::Clock::now();
+        size_t unaccountedSize = sentSize;
+        while (unaccountedSize > 0)
+        {
+            size_t frontRemaining = connection.outputQueue.front().size()
+                - connection.outputOffset;
+            if (unaccountedSize < frontRemaining)
+            {
+                connection.outputOffset += unaccountedSize;
+                break;
+            }
+            unaccountedSize -= frontRemaining;
+            connection.outputQueue.pop_front();
+            connection.outputOffset = 0;
+        }
+    }
+    if (connection.closeAfterFlush)
+    {
+        closeConnectionAndEnableForReuse(connection);
+        return false;
+    }
+    return true;
+}
+
+bool TcpServer::isDispatchAllowed(Connection &connection)
+{
+    uint32_t maxRequestsInFlight = isPipelined() ? config.pipelineDepth : 1;
+    return !connection.closeAfterFlush
+        && connection.requestsInFlight < maxRequestsInFlight
+        && connection.pendingOutputBytes < kOutputHighWaterMarkInBytes;
+}
+
+bool TcpServer::isReadingAllowed(Connection &connection)
+{
+    // unread requests are left to the new process, or to the client
+    // to send again after reconnecting
+    if (draining && !connection.keptInProcess)
+    {
+        return connection.discardInput;
+    }
+    if (!isPipelined())
+    {
+        // a new read could move the frame a worker is reading
+        return isDispatchAllowed(connection);
+    }
+    // pipelined requests are copied out, only buffered input is bounded
+    return !connection.closeAfterFlush
+        && connection.pendingOutputBytes < kOutputHighWaterMarkInBytes
+        && connection.framer.getBufferedSize() < kInputHighWaterMarkInBytes;
+}
+
+bool TcpServer::isPipelined()
+{
+    return executor != nullptr && config.pipelineDepth > 1;
+}
+
+void TcpServer::updateRegisteredEvents(Connection &connection)
+{
+    uint32_t events = edgeTriggeredEvent;
+    if (isReadingAllowed(connection))
+    {
+        events |= readableEvent;
     }
-    else if (socket.revents == POLLHUP || socket.revents == POLLERR)
+    if (!connection.outputQueue.empty())
     {
-        closeConnectionAndEnableForReuse(socket);
+        events |= writableEvent;
     }
+    if (events == connection.registeredEvents)
+    {
+        return;
+    }
+    if (!poller->modify(connection.fd, events, connection.token))
+    {
+        Logger::logWithReturnCode("Poller update failed.", errno, Error);
+        closeConnectionAndEnableForReuse(connection);
+        return;
+    }
+    connection.registeredEvents = events;
 }
 
-void TcpServer::acceptConnection()
+void TcpServer::acceptConnections(int listenerFd)
 {
-    for (unsigned int i = 1; i < kNumberOfSockets; i++)
+    // drain the whole backlog, so a burst of verifiers does not overflow it
+    while (true)
     {
-        if (sockets[i].fd == -1)
+        int clientSocketFd = accept4(listenerFd, nullptr, nullptr,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSocketFd == -1)
         {
-            sockets[i].fd = accept(serverSocketFd, nullptr, nullptr);
-            if (sockets[i].fd == -1)
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                Logger::logWithReturnCode(
+                    "Accept failed, out of file descriptors.", errno, Error);
+                pauseAccepting();
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK)
             {
-                if (errno != EWOULDBLOCK)
-                {
-                    Logger::logWithReturnCode("Accept failed.", errno, Error);
-                }
+                Logger::logWithReturnCode("Accept failed.", errno, Error);
             }
-            Logger::log("Incoming connection: Socket fd: "
-                + std::to_string(sockets[i].fd), Debug);
-            break;
+            return;
+        }
+
+        addConnectedSocket(clientSocketFd);
+    }
+}
+
+bool TcpServer::addConnectedSocket(int clientSocketFd)
+{
+    if (addConnection(clientSocketFd, false) == nullptr)
+    {
+        return false;
+    }
+    Logger::log("Incoming connection: Socket fd: "
+        + std::to_string(clientSocketFd), Debug);
+    return true;
+}
+
+Connection *TcpServer::addConnection(int clientSocketFd, bool ignoreLimit)
+{
+    Connection *connection = connections.allocate(ignoreLimit);
+    if (connection == nullptr)
+    {
+        rejectConnection(clientSocketFd);
+        return nullptr;
+    }
+    connection->registeredEvents = readableEvent | edgeTriggeredEvent;
+    if (!poller->add(clientSocketFd,
+        connection->registeredEvents, connection->token))
+    {
+        Logger::logWithReturnCode(
+            "Poller registration failed.", errno, Error);
+        close(clientSocketFd);
+        connections.release(*connection);
+        return nullptr;
+    }
+    connection->fd = clientSocketFd;
+    connection->lastActivity = TimerQueue::Clock::now();
+    if (config.idleTimeoutInSeconds > 0)
+    {
+        timers.schedule(connection->token, connection->lastActivity
+            + std::chrono::seconds(config.idleTimeoutInSeconds));
+    }
+    Statistics::increment(Statistics::serverConnections);
+    return connection;
+}
+
+void TcpServer::rejectConnection(int clientSocketFd)
+{
+    Logger::log("Connection limit of "
+        + std::to_string(connections.getLimit())
+        + " reached, rejecting connection: Socket fd: "
+        + std::to_string(clientSocketFd), Warning);
+    close(clientSocketFd);
+}
+
+void TcpServer::pauseAccepting()
+{
+    // listener is level triggered, keeping it registered would spin
+    // until some connection closes and frees a file descriptor
+    if (!acceptingPaused)
+    {
+        poller->remove(serverSocketFd);
+        if (unixSocketFd != -1)
+        {
+            poller->remove(unixSocketFd);
+        }
+        acceptingPaused = true;
+    }
+}
+
+void TcpServer::resumeAccepting()
+{
+    if (acceptingPaused && !draining
+        && poller->add(serverSocketFd, readableEvent, kServerSocketToken))
+    {
+        if (unixSocketFd != -1)
+        {
+            poller->add(unixSocketFd, readableEvent, kUnixSocketToken);
         }
+        acceptingPaused = false;
     }
 }
 
-void TcpServer::closeConnectionAndEnableForReuse(pollfd &socket)
+void TcpServer::closeConnectionAndEnableForReuse(Connection &connection)
 {
     Logger::log("Connection closed: Socket fd: "
-        + std::to_string(socket.fd), Info);
-    close(socket.fd);
-    socket.fd = -1;
+        + std::to_string(connection.fd), Debug);
+    timers.cancel(connection.token);
+    if (connection.requestsInFlight == 0)
+    {
+        notifyConnectionClosed(connection.token);
+    }
+    else
+    {
+        // workers still read the requests, buffers are freed on completion
+        OrphanedRequests &orphaned = orphanedRequests[connection.token];
+        orphaned.requestsInFlight = connection.requestsInFlight;
+        orphaned.buffers.push_back(connection.framer.detachBuffer());
+        for (uint32_t id = 0; id < Connection::kMaxRequestsInFlight; id++)
+        {
+            if (connection.idsInFlight & (1 << id))
+            {
+                orphaned.buffers.push_back(
+                    std::move(connection.pipelinedRequests[id]));
+            }
+        }
+    }
+    poller->remove(connection.fd);
+    close(connection.fd);
+    connections.release(connection);
+    Statistics::decrement(Statistics::serverConnections);
+    resumeAccepting();
+}
+
+void TcpServer::releaseOrphanedRequest(uint64_t token)
+{
+    auto itr = orphanedRequests.find(token);
+    if (itr != orphanedRequests.end() && --itr->second.requestsInFlight == 0)
+    {
+        orphanedRequests.erase(itr);
+        notifyConnectionClosed(token);
+    }
+}
+
+void TcpServer::notifyConnectionClosed(uint64_t token)
+{
+    if (connectionClosedCallback != nullptr)
+    {
+        connectionClosedCallback(token);
+    }
+}
+
+void TcpServer::acceptNewProcess()
+{
+    // listener is closed once this reactor starts draining
+    if (drain->isStarted())
+    {
+        return;
+    }
+    int channelFd = HandoffChannel::accept(handoffListenerFd);
+    if (channelFd == -1)
+    {
+        return;
+    }
+    Logger::log("New server process connected, starting hot restart");
+    std::unique_ptr<HandoffChannel> channel =
+        std::make_unique<HandoffChannel>(channelFd);
+    // new process listens on the control socket once this one is gone
+    poller->remove(handoffListenerFd);
+    close(handoffListenerFd);
+    handoffListenerFd = -1;
+    // listeners go first, so the new process accepts before any
+    // connection of this one arrives
+    bool listenersSent =
+        channel->send(HandoffChannel::serverSocket, serverSocketFd)
+        && (unixSocketFd == -1
+            || channel->send(HandoffChannel::unixSocket, unixSocketFd,
+                std::vector<uint8_t> { ownsUnixSocketFile }))
+        && channel->send(HandoffChannel::listenersDone, -1);
+    if (!listenersSent)
+    {
+        Logger::log("Hot restart aborted", Error);
+        setupHandoffListener();
+        return;
+    }
+    drain->start(std::move(channel));
+}
+
+void TcpServer::beginDrain()
+{
+    uint64_t counter;
+    if (read(drain->getNotificationFd(reactorIndex),
+        &counter, sizeof(counter)) == -1 && errno != EAGAIN)
+    {
+        Logger::logWithReturnCode("Eventfd read failed.", errno, Error);
+    }
+    if (draining)
+    {
+        return;
+    }
+    bool handingOver = drain->getChannel() != nullptr;
+    Logger::log(handingOver
+        ? "Handing connections over to new server process"
+        : "Draining connections");
+    closeListeners(handingOver);
+    draining = true;
+    if (config.drainTimeoutInSeconds > 0)
+    {
+        timers.schedule(kDrainTimerId, TimerQueue::Clock::now()
+            + std::chrono::seconds(config.drainTimeoutInSeconds));
+    }
+    connections.forEach([this](Connection &connection)
+    {
+        releaseIfIdle(connection);
+    });
+}
+
+void TcpServer::closeListeners(bool handingOver)
+{
+    // a SO_REUSEPORT listener of this reactor alone is not passed on,
+    // its backlog would be dropped on close
+    bool ownsListener = config.inheritedServerSocketFd == -1;
+    if (handingOver && ownsListener && reactorIndex > 0 && !acceptingPaused)
+    {
+        acceptConnections(serverSocketFd);
+    }
+    pauseAccepting();
+    // a passed listener may still be registered in other reactors
+    if (ownsListener)
+    {
+        close(serverSocketFd);
+        serverSocketFd = -1;
+    }
+    if (unixSocketFd != -1)
+    {
+        close(unixSocketFd);
+        unixSocketFd = -1;
+        // once handed over, the socket file is the new process's
+        if (ownsUnixSocketFile && !handingOver)
+        {
+            unlink(config.unixSocketPath.c_str());
+        }
+    }
+    if (handoffListenerFd != -1)
+    {
+        poller->remove(handoffListenerFd);
+        close(handoffListenerFd);
+        handoffListenerFd = -1;
+        unlink(config.handoffSocketPath.c_str());
+    }
+}
+
+void TcpServer::releaseIfIdle(Connection &connection)
+{
+    // requests already read are answered by this process first
+    if (!draining || connection.fd == -1 || connection.requestsInFlight > 0
+        || !connection.outputQueue.empty() || connection.discardInput)
+    {
+        return;
+    }
+    HandoffChannel *channel = drain->getChannel();
+    // state such as lent sessions is not valid in the new process, so the
+    // client is served here until it gives it back or the drain times out
+    connection.keptInProcess = channel != nullptr
+        && connectionStateQuery != nullptr
+        && connectionStateQuery(connection.token);
+    if (connection.keptInProcess)
+    {
+        return;
+    }
+    // bytes of a request not received completely go along
+    if (channel != nullptr && channel->send(HandoffChannel::connection,
+        connection.fd, connection.framer.getBufferedData()))
+    {
+        Statistics::increment(Statistics::serverConnectionsHandedOver);
+        Logger::log("Connection handed over: Socket fd: "
+            + std::to_string(connection.fd), Debug);
+    }
+    int unreadBytes = 0;
+    if (channel == nullptr
+        && ioctl(connection.fd, FIONREAD, &unreadBytes) == 0 && unreadBytes > 0)
+    {
+        // close would reset the connection and could discard responses
+        // the client has not received yet; it gets end of file instead
+        shutdown(connection.fd, SHUT_WR);
+        connection.discardInput = true;
+        return;
+    }
+    closeConnectionAndEnableForReuse(connection);
+}
+
+void TcpServer::handleDrainTimeout()
+{
+    if (connections.size() > 0)
+    {
+        Logger::log("Drain timeout, closing "
+            + std::to_string(connections.size()) + " busy connection(s)",
+            Warning);
+    }
+    connections.forEach([this](Connection &connection)
+    {
+        closeConnectionAndEnableForReuse(connection);
+    });
+    drainTimedOut = true;
+}
+
+void TcpServer::finishDrainIfDone()
+{
+    // workers may still read requests of connections closed meanwhile
+    if (drainFinished || connections.size() > 0
+        || (!orphanedRequests.empty() && !drainTimedOut))
+    {
+        return;
+    }
+    drainFinished = true;
+    if (!drain->finishReactor())
+    {
+        return;
+    }
+    if (drain->getChannel() != nullptr)
+    {
+        drain->getChannel()->send(HandoffChannel::done, -1);
+        Logger::log("Hot restart complete, terminating");
+    }
+    else
+    {
+        Logger::log(drainTimedOut ? "Drain timeout, terminating"
+            : "All requests finished, terminating");
+    }
+    processFinished = true;
+}
+
+void TcpServer::receiveFromPreviousProcess()
+{
+    HandoffChannel::MessageType type;
+    int fd;
+    std::vector<uint8_t> data;
+    if (!previousProcess->receive(type, fd, data) || type == HandoffChannel::done)
+    {
+        // connections still with the previous process are lost if it died
+        Logger::log("Previous server process is gone, hot restart complete");
+        poller->remove(previousProcess->getFd());
+        previousProcess.reset();
+        if (!draining)
+        {
+            setupHandoffListener();
+        }
+        return;
+    }
+    if (type != HandoffChannel::connection || fd == -1)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+        return;
+    }
+    // previous process served it within the limit, so it is not refused;
+    // requests not sent yet are still in the socket's receive buffer
+    Connection *connection = addConnection(fd, true);
+    if (connection != nullptr)
+    {
+        connection->framer.append(data.data(), data.size());
+        Logger::log("Connection taken over: Socket fd: "
+            + std::to_string(fd), Debug);
+        releaseIfIdle(*connection);
+    }
 }
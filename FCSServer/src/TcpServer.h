@@ -33,42 +33,174 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef TCPSERVER_H
 #define TCPSERVER_H
 
+#include "CompletionQueue.h"
+#include "ConnectionTable.h"
+#include "Drain.h"
+#include "HandoffChannel.h"
+#include "Poller.h"
+#include "RequestExecutor.h"
+#include "ServerConfig.h"
+#include "TimerQueue.h"
+
+#include <chrono>
+#include <memory>
 #include <stddef.h>
 #include <stdint.h>
-#include <sys/poll.h>
+#include <unordered_map>
 #include <vector>
 
+/*
+Single threaded reactor: one listener, poller and connection table. Several
+reactors may listen on the same port, see ReactorPool.
+*/
 class TcpServer
 {
     public:
-        void run(
-            uint32_t portNumber,
-            void (*onMessage)(
-                std::vector<uint8_t>&, std::vector<uint8_t>&));
-        void closeSockets();
+        ~TcpServer();
+
+        void setConfig(const ServerConfig &serverConfig)
+        {
+            config = serverConfig;
+        }
+        // requests are handled inline on this thread without an executor
+        void setExecutor(RequestExecutor *requestExecutor)
+        {
+            executor = requestExecutor;
+        }
+        void setReactorIndex(uint32_t index)
+        {
+            reactorIndex = index;
+            connections.setReactorIndex(index);
+        }
+        // SIGTERM drains connections, and hot restart is possible;
+        // without it signals keep their default action
+        void setDrain(Drain *processDrain)
+        {
+            drain = processDrain;
+        }
+        // never returns, the process ends once draining is done
+        void run(uint32_t portNumber, const MessageHandlers &handlers);
+        // run in steps, e.g. for tests: start, then runOnce until it
+        // returns false because the last reactor finished draining
+        void start(uint32_t portNumber, const MessageHandlers &handlers);
+        // one pass of the event loop, waits at most maxWaitInMilliseconds
+        // for events, -1 waits until the next timer
+        bool runOnce(int maxWaitInMilliseconds);
+        // serves an already connected socket as if it was accepted,
+        // false when refused and closed
+        bool addConnectedSocket(int clientSocketFd);
 
     private:
         void setup(uint32_t portNumber);
-        void dropUnusedConnections();
-        void handleEventIfAny(
-            pollfd &socket,
-            void (*onMessage)(
-                std::vector<uint8_t>&, std::vector<uint8_t>&));
-        void acceptConnection();
-        void closeConnectionAndEnableForReuse(pollfd &socket);
-
-        static const uint32_t kMaxNumberOfConnections = 20;
-        static const uint32_t kPollTimeoutInMilliseconds = 60 * 1000;
-
-        // 1 server socket + client sockets
-        static const uint32_t kNumberOfSockets = kMaxNumberOfConnections + 1;
+        void setupServerSocket(uint32_t portNumber);
+        void setupUnixSocket();
+        void registerUnixSocket();
+        void setupDrain();
+        void setupSignalFd();
+        void handleSignals();
+        void setupHandoffListener();
+        void acceptNewProcess();
+        void beginDrain();
+        void closeListeners(bool handingOver);
+        void releaseIfIdle(Connection &connection);
+        void handleDrainTimeout();
+        void finishDrainIfDone();
+        void receiveFromPreviousProcess();
+        void handleExpiredTimers();
+        void dropIdleConnection(uint64_t token, TimerQueue::Clock::time_point now);
+        void logStatistics();
+        void handleEvent(const PollerEvent &event);
+        void handleCompletions();
+        void readFromConnection(Connection &connection);
+        void dispatchFrames(Connection &connection);
+        void handleMessage(Connection &connection, BufferView message);
+        void handlePipelinedMessage(
+            Connection &connection, BufferView message, uint8_t requestId);
+        void completeMessage(
+            Connection &connection, ResponseMessage &response);
+        // returns false when the connection got closed
+        bool flushOutput(Connection &connection);
+        bool isDispatchAllowed(Connection &connection);
+        bool isReadingAllowed(Connection &connection);
+        bool isPipelined();
+        void updateRegisteredEvents(Connection &connection);
+        void acceptConnections(int listenerFd);
+        // nullptr when the connection got closed instead
+        Connection *addConnection(int clientSocketFd, bool ignoreLimit);
+        void rejectConnection(int clientSocketFd);
+        void pauseAccepting();
+        void resumeAccepting();
+        void closeConnectionAndEnableForReuse(Connection &connection);
+        void releaseOrphanedRequest(uint64_t token);
+        void notifyConnectionClosed(uint64_t token);
+
+        // connection tokens always have non-zero generation in the high half,
+        // so values below 2^32 are free for the server's own file descriptors
+        static const uint64_t kServerSocketToken = 0;
+        static const uint64_t kCompletionToken = 1;
+        static const uint64_t kUnixSocketToken = 2;
+        static const uint64_t kHandoffListenerToken = 3;
+        static const uint64_t kDrainStartToken = 4;
+        static const uint64_t kPreviousProcessToken = 5;
+        static const uint64_t kSignalToken = 6;
+        // timer ids share the connection token space as well
+        static const uint64_t kStatisticsTimerId = 0;
+        static const uint64_t kWatchdogTimerId = 1;
+        static const uint64_t kDrainTimerId = 2;
+        // size of a single read, frames are reassembled by MessageFramer
         static const uint32_t kMaxMessageSizeInBytes = 10000;
-
-        std::vector<uint8_t> messageBuffer
-            = std::vector<uint8_t>(kMaxMessageSizeInBytes);
-
-        pollfd sockets[kNumberOfSockets];
+        // no more requests are read from a connection with this much unsent output
+        static const size_t kOutputHighWaterMarkInBytes = 64 * 1024;
+        // nor, in pipelined mode, with this many received bytes not dispatched
+        static const size_t kInputHighWaterMarkInBytes = 64 * 1024;
+        // limits how many queued responses one sendmsg gathers
+        static const size_t kMaxIovecsPerSend = 16;
+
+        ServerConfig config;
+        // half the systemd watchdog timeout, zero when disabled
+        std::chrono::microseconds watchdogInterval{0};
+        uint32_t reactorIndex = 0;
+        RequestCallback messageCallback = nullptr;
+        ConnectionCallback connectionClosedCallback = nullptr;
+        ConnectionQuery connectionStateQuery = nullptr;
+        ShutdownCallback shutdownCallback = nullptr;
+        std::unique_ptr<Poller> poller;
+        std::vector<PollerEvent> readyEvents;
+        // idle timers are keyed by connection token
+        TimerQueue timers;
+        ConnectionTable connections;
+        RequestExecutor *executor = nullptr;
+        CompletionQueue completionQueue;
+        std::vector<Completion> completions;
+        // buffers of connections closed while workers still read requests
+        // from them, kept until the last of those requests completes
+        struct OrphanedRequests
+        {
+            std::vector<std::vector<uint8_t>> buffers;
+            uint32_t requestsInFlight = 0;
+        };
+        std::unordered_map<uint64_t, OrphanedRequests> orphanedRequests;
         int serverSocketFd = -1;
+        // -1 unless config.unixSocketPath is set, only on first reactor
+        int unixSocketFd = -1;
+        // false when the service manager created the socket file
+        bool ownsUnixSocketFile = false;
+        // set when process ran out of file descriptors
+        bool acceptingPaused = false;
+        // SIGINT and SIGTERM, only on first reactor
+        int signalFd = -1;
+        Drain *drain = nullptr;
+        // no more requests are read, connections are closed or go to
+        // the new process once idle
+        bool draining = false;
+        // requests still in flight are abandoned
+        bool drainTimedOut = false;
+        bool drainFinished = false;
+        // last reactor finished draining, the process ends
+        bool processFinished = false;
+        // hot restart, only on first reactor
+        int handoffListenerFd = -1;
+        std::unique_ptr<HandoffChannel> previousProcess;
 };
 
 #endif /* TCPSERVER_H */
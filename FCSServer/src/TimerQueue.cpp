@@ -0,0 +1,159 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#include "TimerQueue.h"
+
+#include <limits>
+
+void TimerQueue::schedule(uint64_t timerId, Clock::time_point deadline)
+{
+    auto itr = indexByTimerId.find(timerId);
+    if (itr != indexByTimerId.end())
+    {
+        size_t index = itr->second;
+        Clock::time_point previousDeadline = heap[index].deadline;
+        heap[index].deadline = deadline;
+        if (deadline < previousDeadline)
+        {
+            siftUp(index);
+        }
+        else
+        {
+            siftDown(index);
+        }
+        return;
+    }
+    indexByTimerId[timerId] = heap.size();
+    heap.push_back(Entry { deadline, timerId });
+    siftUp(heap.size() - 1);
+}
+
+void TimerQueue::cancel(uint64_t timerId)
+{
+    auto itr = indexByTimerId.find(timerId);
+    if (itr != indexByTimerId.end())
+    {
+        removeAt(itr->second);
+    }
+}
+
+bool TimerQueue::popExpired(Clock::time_point now, uint64_t &timerId)
+{
+    if (heap.empty() || heap.front().deadline > now)
+    {
+        return false;
+    }
+    timerId = heap.front().timerId;
+    removeAt(0);
+    return true;
+}
+
+int TimerQueue::getTimeoutInMilliseconds(Clock::time_point now) const
+{
+    if (heap.empty())
+    {
+        return -1;
+    }
+    if (heap.front().deadline <= now)
+    {
+        return 0;
+    }
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        heap.front().deadline - now).count();
+    if (remaining > std::numeric_limits<int>::max())
+    {
+        return std::numeric_limits<int>::max();
+    }
+    return static_cast<int>(remaining);
+}
+
+void TimerQueue::removeAt(size_t index)
+{
+    indexByTimerId.erase(heap[index].timerId);
+    size_t lastIndex = heap.size() - 1;
+    if (index != lastIndex)
+    {
+        heap[index] = heap[lastIndex];
+        indexByTimerId[heap[index].timerId] = index;
+    }
+    heap.pop_back();
+    if (index < heap.size())
+    {
+        siftDown(index);
+        siftUp(index);
+    }
+}
+
+void TimerQueue::siftUp(size_t index)
+{
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (heap[parent].deadline <= heap[index].deadline)
+        {
+            break;
+        }
+        swapEntries(parent, index);
+        index = parent;
+    }
+}
+
+void TimerQueue::siftDown(size_t index)
+{
+    while (true)
+    {
+        size_t smallest = index;
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+        if (left < heap.size() && heap[left].deadline < heap[smallest].deadline)
+        {
+            smallest = left;
+        }
+        if (right < heap.size() && heap[right].deadline < heap[smallest].deadline)
+        {
+            smallest = right;
+        }
+        if (smallest == index)
+        {
+            break;
+        }
+        swapEntries(smallest, index);
+        index = smallest;
+    }
+}
+
+void TimerQueue::swapEntries(size_t first, size_t second)
+{
+    std::swap(heap[first], heap[second]);
+    indexByTimerId[heap[first].timerId] = first;
+    indexByTimerId[heap[second].timerId] = second;
+}
@@ -0,0 +1,78 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+#ifndef TIMERQUEUE_H
+#define TIMERQUEUE_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+/*
+Indexed binary min-heap of deadlines. Scheduling, rescheduling, cancelling
+and popping cost O(log n), reading the nearest deadline costs O(1).
+*/
+class TimerQueue
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        // Inserts the timer or moves it if it is already scheduled
+        void schedule(uint64_t timerId, Clock::time_point deadline);
+        void cancel(uint64_t timerId);
+        bool popExpired(Clock::time_point now, uint64_t &timerId);
+        // -1 (wait forever) when empty, rounded up so the deadline has passed on wakeup
+        int getTimeoutInMilliseconds(Clock::time_point now) const;
+        bool empty() const
+        {
+            return heap.empty();
+        }
+
+    private:
+        struct Entry
+        {
+            Clock::time_point deadline;
+            uint64_t timerId;
+        };
+
+        void removeAt(size_t index);
+        void siftUp(size_t index);
+        void siftDown(size_t index);
+        void swapEntries(size_t first, size_t second);
+
+        std::vector<Entry> heap;
+        std::unordered_map<uint64_t, size_t> indexByTimerId;
+};
+
+#endif /* TIMERQUEUE_H */
@@ -31,47 +31,372 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 
-#include "TcpServer.h"
+#include "CommandRegistry.h"
+#include "Connection.h"
+#include "CryptoSessionPool.h"
+#include "FcsDevice.h"
+#include "HandoffChannel.h"
+#include "ReactorPool.h"
+#include "ResponseCache.h"
 #include "MessageHandler.h"
 #include "Logger.h"
+#include "ServerConfig.h"
+#include "Systemd.h"
 
-#include <signal.h>
+#include <stdlib.h>
 #include <string>
+#include <sys/socket.h>
+#include <unistd.h>
 
-TcpServer server;
+ReactorPool server;
+// one mailbox serves all requests, more workers only deepen the queue
+const uint32_t kMaxWorkers = 64;
+const uint32_t kMaxReactors = 64;
+const uint32_t kMaxCryptoSessions = 64;
 
-void onSignal(sig_atomic_t s)
+void printUsageAndExit()
+{
+    Logger::log("Usage: <executable name> <port number> optional:<log level> optional:<options> e.g ./fcsServer 50001 Debug --poller=poll", Fatal);
+    Logger::log("Possible log levels: Debug, Info (default), Warning, Error, Fatal", Fatal);
+    Logger::log("Possible options:", Fatal);
+    Logger::log("  --poller=<epoll|io_uring|poll> event loop backend (default epoll)", Fatal);
+    Logger::log("  --idle-timeout=<seconds> drop connections idle for this long, 0 disables (default 60)", Fatal);
+    Logger::log("  --max-connections=<count> connections served at once, more are rejected (default 20)", Fatal);
+    Logger::log("  --listen-backlog=<count> connections queued by the kernel before accept (default " + std::to_string(SOMAXCONN) + ")", Fatal);
+    Logger::log("  --unix-socket=<path> also listen on a unix domain socket at this path (default disabled)", Fatal);
+    Logger::log("  --unix-socket-mode=<octal> permissions of the unix socket (default 0660)", Fatal);
+    Logger::log("  --reactors=<count> network threads, each with its own listener on the port (default 1)", Fatal);
+    Logger::log("  --workers=<count> threads handling requests, 0 handles them on the network thread (default 1)", Fatal);
+    Logger::log("  --device-handles=<count> /dev/fcs descriptors kept open for concurrent requests (default one per worker)", Fatal);
+    Logger::log("  --response-cache=<0|1> answer chip ID, ID code, device identity and certificates from memory after the first call (default 1)", Fatal);
+    Logger::log("  --response-cache-ttl=<seconds> age of cached responses, 0 keeps them until certificate reload or device reset (default 0)", Fatal);
+    Logger::log("  --crypto-sessions=<count> crypto service sessions kept open and lent to clients, 0 disables (default 0)", Fatal);
+    Logger::log("  --pipeline-depth=<count> requests of one connection handled at once, above 1 responses come in completion order (default 1, at most " + std::to_string(Connection::kMaxRequestsInFlight) + ")", Fatal);
+    Logger::log("  --client-rate=<count> requests per second of each connection, more are answered busy, 0 disables (default 0)", Fatal);
+    Logger::log("  --client-burst=<count> requests a client may send in a burst before its rate applies (default same as rate)", Fatal);
+    Logger::log("  --shed-pending=<count> answer retry later while this many requests are pending, 0 disables (default 0)", Fatal);
+    Logger::log("  --shed-service-time=<ms> answer retry later while all workers are busy and requests take this long, 0 disables (default 0)", Fatal);
+    Logger::log("  --drain-timeout=<seconds> on SIGTERM, wait this long for requests in flight, 0 waits indefinitely (default 30)", Fatal);
+    Logger::log("  --hot-restart-socket=<path> control socket a new server process takes over connections through (default disabled)", Fatal);
+    Logger::log("  --stats-interval=<seconds> log statistics periodically, 0 disables (default 0)", Fatal);
+    exit(1);
+}
+
+bool startsWith(const std::string &argument, const std::string &prefix)
 {
-    if (s == SIGINT || s == SIGTERM)
+    return argument.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool parseUnsigned(const std::string &value, uint32_t &result)
+{
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
     {
-        Logger::log("Signal caught, terminating");
-        server.closeSockets();
-        exit(0);
+        return false;
     }
+    try
+    {
+        unsigned long parsed = std::stoul(value);
+        if (parsed > UINT32_MAX)
+        {
+            return false;
+        }
+        result = parsed;
+    }
+    catch(const std::exception& e)
+    {
+        return false;
+    }
+    return true;
 }
 
-void printUsageAndExit()
+bool parseOctal(const std::string &value, uint32_t &result)
 {
-    Logger::log("Usage: <executable name> <port number> optional:<log level> e.g ./fcsServer 50001 Debug", Fatal);
-    Logger::log("Possible log levels: Debug, Info (default), Warning, Error, Fatal", Fatal);
-    exit(1);
+    if (value.empty() || value.size() > 4
+        || value.find_first_not_of("01234567") != std::string::npos)
+    {
+        return false;
+    }
+    result = std::stoul(value, nullptr, 8);
+    return result <= 0777;
 }
 
-int main(int argc, char* argv[])
+bool parseOption(const std::string &argument, ServerConfig &config)
 {
-    signal(SIGINT, onSignal);
-    signal(SIGTERM, onSignal);
-    if (argc == 3)
+    const std::string pollerOption = "--poller=";
+    const std::string idleTimeoutOption = "--idle-timeout=";
+    const std::string maxConnectionsOption = "--max-connections=";
+    const std::string listenBacklogOption = "--listen-backlog=";
+    const std::string unixSocketOption = "--unix-socket=";
+    const std::string unixSocketModeOption = "--unix-socket-mode=";
+    const std::string reactorsOption = "--reactors=";
+    const std::string workersOption = "--workers=";
+    const std::string deviceHandlesOption = "--device-handles=";
+    const std::string responseCacheOption = "--response-cache=";
+    const std::string responseCacheTtlOption = "--response-cache-ttl=";
+    const std::string cryptoSessionsOption = "--crypto-sessions=";
+    const std::string pipelineDepthOption = "--pipeline-depth=";
+    const std::string clientRateOption = "--client-rate=";
+    const std::string clientBurstOption = "--client-burst=";
+    const std::string shedPendingOption = "--shed-pending=";
+    const std::string shedServiceTimeOption = "--shed-service-time=";
+    const std::string drainTimeoutOption = "--drain-timeout=";
+    const std::string hotRestartSocketOption = "--hot-restart-socket=";
+    const std::string statisticsIntervalOption = "--stats-interval=";
+    if (startsWith(argument, pollerOption))
+    {
+        return Poller::parseBackend(
+            argument.substr(pollerOption.size()), config.pollerBackend);
+    }
+    if (startsWith(argument, idleTimeoutOption))
+    {
+        return parseUnsigned(
+            argument.substr(idleTimeoutOption.size()),
+            config.idleTimeoutInSeconds);
+    }
+    if (startsWith(argument, maxConnectionsOption))
+    {
+        return parseUnsigned(
+            argument.substr(maxConnectionsOption.size()),
+            config.maxConnections);
+    }
+    if (startsWith(argument, listenBacklogOption))
     {
-        if (!Logger::setCurrentLogLevel(std::string(argv[2])))
+        return parseUnsigned(
+            argument.substr(listenBacklogOption.size()),
+            config.listenBacklog)
+            && config.listenBacklog <= INT32_MAX;
+    }
+    if (startsWith(argument, unixSocketOption))
+    {
+        config.unixSocketPath = argument.substr(unixSocketOption.size());
+        return !config.unixSocketPath.empty();
+    }
+    if (startsWith(argument, unixSocketModeOption))
+    {
+        return parseOctal(
+            argument.substr(unixSocketModeOption.size()),
+            config.unixSocketMode);
+    }
+    if (startsWith(argument, reactorsOption))
+    {
+        return parseUnsigned(
+            argument.substr(reactorsOption.size()),
+            config.reactors)
+            && config.reactors > 0 && config.reactors <= kMaxReactors;
+    }
+    if (startsWith(argument, workersOption))
+    {
+        return parseUnsigned(
+            argument.substr(workersOption.size()),
+            config.workers)
+            && config.workers <= kMaxWorkers;
+    }
+    if (startsWith(argument, deviceHandlesOption))
+    {
+        return parseUnsigned(
+            argument.substr(deviceHandlesOption.size()),
+            config.deviceHandles)
+            && config.deviceHandles > 0 && config.deviceHandles <= kMaxWorkers;
+    }
+    if (startsWith(argument, responseCacheOption))
+    {
+        uint32_t enabled;
+        if (!parseUnsigned(argument.substr(responseCacheOption.size()), enabled)
+            || enabled > 1)
         {
-            printUsageAndExit();
+            return false;
         }
+        config.responseCache = enabled == 1;
+        return true;
+    }
+    if (startsWith(argument, responseCacheTtlOption))
+    {
+        return parseUnsigned(
+            argument.substr(responseCacheTtlOption.size()),
+            config.responseCacheTtlInSeconds);
+    }
+    if (startsWith(argument, cryptoSessionsOption))
+    {
+        return parseUnsigned(
+            argument.substr(cryptoSessionsOption.size()),
+            config.cryptoSessions)
+            && config.cryptoSessions <= kMaxCryptoSessions;
+    }
+    if (startsWith(argument, pipelineDepthOption))
+    {
+        return parseUnsigned(
+            argument.substr(pipelineDepthOption.size()),
+            config.pipelineDepth)
+            && config.pipelineDepth > 0
+            && config.pipelineDepth <= Connection::kMaxRequestsInFlight;
+    }
+    if (startsWith(argument, clientRateOption))
+    {
+        return parseUnsigned(
+            argument.substr(clientRateOption.size()),
+            config.clientRequestRate);
     }
-    if (argc < 2 || argc > 3)
+    if (startsWith(argument, clientBurstOption))
+    {
+        return parseUnsigned(
+            argument.substr(clientBurstOption.size()),
+            config.clientRequestBurst);
+    }
+    if (startsWith(argument, shedPendingOption))
+    {
+        return parseUnsigned(
+            argument.substr(shedPendingOption.size()),
+            config.shedPendingRequests);
+    }
+    if (startsWith(argument, shedServiceTimeOption))
+    {
+        return parseUnsigned(
+            argument.substr(shedServiceTimeOption.size()),
+            config.shedServiceTimeInMilliseconds);
+    }
+    if (startsWith(argument, drainTimeoutOption))
+    {
+        return parseUnsigned(
+            argument.substr(drainTimeoutOption.size()),
+            config.drainTimeoutInSeconds);
+    }
+    if (startsWith(argument, hotRestartSocketOption))
+    {
+        config.handoffSocketPath = argument.substr(hotRestartSocketOption.size());
+        return !config.handoffSocketPath.empty();
+    }
+    if (startsWith(argument, statisticsIntervalOption))
+    {
+        return parseUnsigned(
+            argument.substr(statisticsIntervalOption.size()),
+            config.statisticsIntervalInSeconds);
+    }
+    return false;
+}
+
+void setupResponseCache(const ServerConfig &config)
+{
+    // options apply to every command the registry marks cacheable
+    for (uint32_t code = 0; code < CommandRegistry::kCodeSpace; code++)
+    {
+        ResponseCache::Policy policy = CommandRegistry::get(code).cache;
+        if (!policy.cacheable)
+        {
+            continue;
+        }
+        policy.cacheable = config.responseCache;
+        policy.ttlInSeconds = config.responseCacheTtlInSeconds;
+        ResponseCache::setPolicy(code, policy);
+    }
+}
+
+// sessions are opened ahead of the first client, the rest on demand
+void setupCryptoSessions(const ServerConfig &config)
+{
+    CryptoSessionPool::setMaxSessions(config.cryptoSessions);
+    if (config.cryptoSessions == 0)
+    {
+        return;
+    }
+    // exit() after a fatal error; drain and signals end with _exit and
+    // close them through MessageHandlers::onShutdown instead
+    atexit(&handleShutdown);
+    if (!CryptoSessionPool::fill())
+    {
+        Logger::log("Not all crypto sessions could be opened in advance", Warning);
+    }
+}
+
+// with socket activation, listeners come from the .socket unit and
+// the port and --unix-socket only apply when started without it
+void takeInheritedSockets(ServerConfig &config)
+{
+    for (int fd : Systemd::takeListenFds())
+    {
+        sockaddr_storage address = {};
+        socklen_t addressSize = sizeof(address);
+        getsockname(fd, (sockaddr*)&address, &addressSize);
+        int &inheritedFd = address.ss_family == AF_UNIX
+            ? config.inheritedUnixSocketFd : config.inheritedServerSocketFd;
+        if (inheritedFd != -1)
+        {
+            Logger::log("Ignoring additional socket passed by systemd: "
+                + std::to_string(fd), Warning);
+            close(fd);
+            continue;
+        }
+        inheritedFd = fd;
+    }
+}
+
+// a server already running with the same control socket hands over its
+// listeners now, and its connections once the reactors run
+void takeOverFromRunningServer(ServerConfig &config)
+{
+    int channelFd = HandoffChannel::connect(config.handoffSocketPath);
+    if (channelFd == -1)
+    {
+        return;
+    }
+    Logger::log("Taking over from running server process");
+    HandoffChannel channel(channelFd);
+    while (true)
+    {
+        HandoffChannel::MessageType type;
+        int fd;
+        std::vector<uint8_t> data;
+        if (!channel.receive(type, fd, data))
+        {
+            Logger::log("Hot restart failed, running server process is gone", Fatal);
+            exit(1);
+        }
+        if (type == HandoffChannel::listenersDone)
+        {
+            break;
+        }
+        if (fd == -1)
+        {
+            continue;
+        }
+        int &inheritedFd = type == HandoffChannel::unixSocket
+            ? config.inheritedUnixSocketFd : config.inheritedServerSocketFd;
+        // the same socket may have been passed by systemd as well
+        if (inheritedFd != -1)
+        {
+            close(fd);
+            continue;
+        }
+        inheritedFd = fd;
+        if (type == HandoffChannel::unixSocket)
+        {
+            config.ownsInheritedUnixSocketFile = !data.empty() && data[0];
+        }
+    }
+    config.previousProcessFd = channel.release();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
     {
         printUsageAndExit();
     }
+    ServerConfig config;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string argument(argv[i]);
+        if (startsWith(argument, "--"))
+        {
+            if (!parseOption(argument, config))
+            {
+                printUsageAndExit();
+            }
+        }
+        else if (i != 2 || !Logger::setCurrentLogLevel(argument))
+        {
+            printUsageAndExit();
+        }
+    }
     int portNumber;
     try
     {
@@ -86,7 +411,23 @@ int main(int argc, char* argv[])
     {
         Logger::log("FCS Server build on: "
             + std::string(__DATE__) + " " + std::string(__TIME__), Debug);
-        server.run(portNumber, &handleIncomingMessage);
+        takeInheritedSockets(config);
+        // without workers, reactors call the device themselves
+        uint32_t deviceCallers =
+            config.workers > 0 ? config.workers : config.reactors;
+        FcsDevice::setMaxOpenHandles(config.deviceHandles > 0
+            ? config.deviceHandles : deviceCallers);
+        setupResponseCache(config);
+        if (!config.handoffSocketPath.empty())
+        {
+            takeOverFromRunningServer(config);
+        }
+        server.setConfig(config);
+        setupCryptoSessions(config);
+        server.run(portNumber, MessageHandlers { &handleIncomingMessage,
+            &handleBusyMessage, &handleRetryLaterMessage,
+            &handleClosedConnection, &holdsConnectionState,
+            &handleShutdown });
     }
     catch(const std::exception& e)
     {
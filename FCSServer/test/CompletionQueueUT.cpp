@@ -0,0 +1,90 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "CompletionQueue.h"
+
+#include <poll.h>
+#include <thread>
+
+static bool isNotified(CompletionQueue &queue, int timeoutInMilliseconds = 0)
+{
+    pollfd notification { queue.getNotificationFd(), POLLIN, 0 };
+    return poll(&notification, 1, timeoutInMilliseconds) == 1;
+}
+
+TEST(CompletionQueueUT, take_completionsInPushOrder)
+{
+    CompletionQueue queue;
+    ASSERT_TRUE(queue.open());
+    EXPECT_FALSE(isNotified(queue));
+
+    queue.push(Completion { 1, 2, {} });
+    queue.push(Completion { 3, 4, {} });
+    EXPECT_TRUE(isNotified(queue));
+
+    std::vector<Completion> taken;
+    queue.take(taken);
+    ASSERT_EQ((size_t)2, taken.size());
+    EXPECT_EQ((uint64_t)1, taken[0].connectionToken);
+    EXPECT_EQ(2, taken[0].requestId);
+    EXPECT_EQ((uint64_t)3, taken[1].connectionToken);
+    EXPECT_EQ(4, taken[1].requestId);
+    //taking resets the notification
+    EXPECT_FALSE(isNotified(queue));
+
+    queue.take(taken);
+    EXPECT_TRUE(taken.empty());
+}
+
+TEST(CompletionQueueUT, push_fromOtherThreadWakesPoll)
+{
+    CompletionQueue queue;
+    ASSERT_TRUE(queue.open());
+    std::thread worker([&queue]
+    {
+        ResponseMessage response;
+        response.setHeader(0x01000000);
+        queue.push(Completion { 5, 1, std::move(response) });
+    });
+    EXPECT_TRUE(isNotified(queue, 5000));
+    worker.join();
+
+    std::vector<Completion> taken;
+    queue.take(taken);
+    ASSERT_EQ((size_t)1, taken.size());
+    EXPECT_EQ((uint64_t)5, taken[0].connectionToken);
+    EXPECT_EQ(std::vector<uint8_t>({0x00, 0x00, 0x00, 0x01}),
+        taken[0].response.toVector());
+}
@@ -0,0 +1,123 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "ConnectionTable.h"
+
+TEST(ConnectionTableUT, release_slotReusedWithNewGeneration)
+{
+    ConnectionTable connections;
+    connections.setLimit(2);
+    Connection *first = connections.allocate();
+    ASSERT_NE(nullptr, first);
+    first->fd = 10;
+    uint64_t firstToken = first->token;
+    //server's own descriptors use tokens below 2^32
+    EXPECT_GE(firstToken, (uint64_t)1 << 32);
+    EXPECT_EQ(first, connections.find(firstToken));
+
+    connections.release(*first);
+    EXPECT_EQ(nullptr, connections.find(firstToken));
+    EXPECT_EQ((size_t)0, connections.size());
+
+    Connection *second = connections.allocate();
+    ASSERT_NE(nullptr, second);
+    second->fd = 11;
+    EXPECT_EQ(first, second);
+    EXPECT_NE(firstToken, second->token);
+    EXPECT_EQ((uint32_t)firstToken, (uint32_t)second->token);
+    EXPECT_EQ(nullptr, connections.find(firstToken));
+    EXPECT_EQ(second, connections.find(second->token));
+}
+
+TEST(ConnectionTableUT, allocate_limit)
+{
+    ConnectionTable connections;
+    connections.setLimit(2);
+    Connection *first = connections.allocate();
+    Connection *second = connections.allocate();
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_NE(first->token, second->token);
+    EXPECT_EQ(nullptr, connections.allocate());
+
+    //e.g. connections handed over by the previous process
+    Connection *third = connections.allocate(true);
+    ASSERT_NE(nullptr, third);
+    EXPECT_EQ((size_t)3, connections.size());
+
+    connections.release(*first);
+    EXPECT_EQ(nullptr, connections.allocate());
+    connections.release(*second);
+    EXPECT_NE(nullptr, connections.allocate());
+}
+
+TEST(ConnectionTableUT, forEach_visitsOpenConnectionsOnly)
+{
+    ConnectionTable connections;
+    connections.setLimit(3);
+    for (int fd = 10; fd < 13; fd++)
+    {
+        connections.allocate()->fd = fd;
+    }
+    Connection *released = connections.find(connections.allocate(true)->token);
+    EXPECT_EQ(nullptr, released);
+
+    std::vector<int> visited;
+    connections.forEach([&visited](Connection &connection)
+    {
+        visited.push_back(connection.fd);
+    });
+    EXPECT_EQ(std::vector<int>({10, 11, 12}), visited);
+}
+
+TEST(ConnectionTableUT, find_tokenOfOtherReactorNotFound)
+{
+    ConnectionTable firstReactor;
+    ConnectionTable secondReactor;
+    firstReactor.setLimit(1);
+    secondReactor.setLimit(1);
+    secondReactor.setReactorIndex(1);
+    Connection *first = firstReactor.allocate();
+    Connection *second = secondReactor.allocate();
+    first->fd = 10;
+    second->fd = 11;
+
+    //same slot and generation, told apart by the reactor index
+    EXPECT_EQ((uint64_t)0, (first->token >> 24) & 0xff);
+    EXPECT_EQ((uint64_t)1, (second->token >> 24) & 0xff);
+    EXPECT_EQ(nullptr, firstReactor.find(second->token));
+    EXPECT_EQ(nullptr, secondReactor.find(first->token));
+    EXPECT_EQ(second, secondReactor.find(second->token));
+}
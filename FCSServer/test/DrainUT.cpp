@@ -0,0 +1,87 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "Drain.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+
+static bool isNotified(Drain &drain, uint32_t reactorIndex)
+{
+    pollfd notification { drain.getNotificationFd(reactorIndex), POLLIN, 0 };
+    return poll(&notification, 1, 0) == 1;
+}
+
+TEST(DrainUT, start_notifiesEveryReactorOnce)
+{
+    Drain drain;
+    ASSERT_TRUE(drain.open(2));
+    EXPECT_FALSE(drain.isStarted());
+    EXPECT_FALSE(isNotified(drain, 0));
+    EXPECT_FALSE(isNotified(drain, 1));
+
+    EXPECT_TRUE(drain.start(nullptr));
+    EXPECT_TRUE(drain.isStarted());
+    EXPECT_TRUE(isNotified(drain, 0));
+    EXPECT_TRUE(isNotified(drain, 1));
+    EXPECT_EQ(nullptr, drain.getChannel());
+    //a second signal or new process does not restart it
+    EXPECT_FALSE(drain.start(nullptr));
+}
+
+TEST(DrainUT, start_keepsNewProcessChannel)
+{
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    HandoffChannel peer(sockets[1]);
+    std::unique_ptr<HandoffChannel> channel =
+        std::make_unique<HandoffChannel>(sockets[0]);
+    HandoffChannel *expectedChannel = channel.get();
+
+    Drain drain;
+    ASSERT_TRUE(drain.open(1));
+    EXPECT_TRUE(drain.start(std::move(channel)));
+    EXPECT_EQ(expectedChannel, drain.getChannel());
+}
+
+TEST(DrainUT, finishReactor_lastReactorEndsProcess)
+{
+    Drain drain;
+    ASSERT_TRUE(drain.open(3));
+    ASSERT_TRUE(drain.start(nullptr));
+    EXPECT_FALSE(drain.finishReactor());
+    EXPECT_FALSE(drain.finishReactor());
+    EXPECT_TRUE(drain.finishReactor());
+}
@@ -0,0 +1,179 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "ConnectionTable.h"
+#include "FairQueue.h"
+
+typedef FairQueue::Clock Clock;
+
+//get_chipid with id 0, client 0
+static const std::vector<uint8_t> kChipIdRequest {0x12, 0x00, 0x00, 0x00};
+//get_measurement, no payload
+static const std::vector<uint8_t> kMeasurementRequest {0x83, 0x01, 0x00, 0x00};
+
+static QueuedRequest makeRequest(
+    uint64_t connectionToken, const std::vector<uint8_t> &message, uint8_t id = 0)
+{
+    return QueuedRequest { nullptr, connectionToken, id, message, Clock::now() };
+}
+
+static std::vector<uint64_t> popAll(FairQueue &queue)
+{
+    std::vector<uint64_t> order;
+    QueuedRequest request;
+    while (queue.pop(request))
+    {
+        order.push_back(request.connectionToken);
+    }
+    return order;
+}
+
+TEST(FairQueueUT, pop_clientsTakeTurns)
+{
+    FairQueue queue;
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(queue.push(makeRequest(1, kChipIdRequest), now));
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_TRUE(queue.push(makeRequest(2, kChipIdRequest), now));
+    }
+    EXPECT_EQ((size_t)6, queue.size());
+    EXPECT_EQ(std::vector<uint64_t>({1, 2, 1, 2, 1, 1}), popAll(queue));
+    EXPECT_EQ((size_t)0, queue.size());
+}
+
+TEST(FairQueueUT, pop_slowCommandsServedLessOften)
+{
+    FairQueue queue;
+    queue.recordServiceTime(0x183, 3000);
+    queue.recordServiceTime(0x12, 1000);
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_TRUE(queue.push(makeRequest(1, kMeasurementRequest), now));
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_TRUE(queue.push(makeRequest(2, kChipIdRequest), now));
+    }
+    //client 2 gets three requests served per slow one of client 1
+    EXPECT_EQ(std::vector<uint64_t>({2, 2, 1, 2, 2, 2, 1, 2}), popAll(queue));
+}
+
+TEST(FairQueueUT, push_rateLimitRefillsOverTime)
+{
+    FairQueue queue;
+    queue.setRateLimit(2, 2);
+    Clock::time_point now = Clock::now();
+    EXPECT_TRUE(queue.push(makeRequest(1, kChipIdRequest), now));
+    EXPECT_TRUE(queue.push(makeRequest(1, kChipIdRequest), now));
+    EXPECT_FALSE(queue.push(makeRequest(1, kChipIdRequest), now));
+    //other clients keep their own budget
+    EXPECT_TRUE(queue.push(makeRequest(2, kChipIdRequest), now));
+
+    now += std::chrono::milliseconds(500);
+    EXPECT_TRUE(queue.push(makeRequest(1, kChipIdRequest), now));
+    EXPECT_FALSE(queue.push(makeRequest(1, kChipIdRequest), now));
+    EXPECT_EQ((size_t)4, queue.size());
+}
+
+TEST(FairQueueUT, push_batchTakesTokenPerRequest)
+{
+    //batch of three get_chipid requests
+    std::vector<uint8_t> batchOfThree {0xf0, 0x37, 0x00, 0x00,
+        0x12, 0x00, 0x00, 0x01, 0x12, 0x00, 0x00, 0x02, 0x12, 0x00, 0x00, 0x03};
+    FairQueue queue;
+    queue.setRateLimit(1, 3);
+    Clock::time_point now = Clock::now();
+    EXPECT_TRUE(queue.push(makeRequest(1, batchOfThree), now));
+    EXPECT_FALSE(queue.push(makeRequest(1, kChipIdRequest), now));
+
+    EXPECT_TRUE(queue.push(makeRequest(2, kChipIdRequest), now));
+    EXPECT_FALSE(queue.push(makeRequest(2, batchOfThree), now));
+}
+
+TEST(FairQueueUT, push_sameSlotOnOtherReactorIsOtherClient)
+{
+    ConnectionTable firstReactor;
+    ConnectionTable secondReactor;
+    firstReactor.setLimit(1);
+    secondReactor.setLimit(1);
+    secondReactor.setReactorIndex(1);
+    uint64_t firstToken = firstReactor.allocate()->token;
+    uint64_t secondToken = secondReactor.allocate()->token;
+    EXPECT_NE(firstToken, secondToken);
+
+    FairQueue queue;
+    queue.setRateLimit(1, 1);
+    Clock::time_point now = Clock::now();
+    EXPECT_TRUE(queue.push(makeRequest(firstToken, kChipIdRequest), now));
+    EXPECT_TRUE(queue.push(makeRequest(secondToken, kChipIdRequest), now));
+    EXPECT_FALSE(queue.push(makeRequest(firstToken, kChipIdRequest), now));
+}
+
+TEST(FairQueueUT, pop_commandLongerThanQuantumSavesUpDeficit)
+{
+    FairQueue queue;
+    queue.recordServiceTime(0x183, 5000);
+    queue.recordServiceTime(0x12, 1000);
+    Clock::time_point now = Clock::now();
+    EXPECT_TRUE(queue.push(makeRequest(1, kMeasurementRequest), now));
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_TRUE(queue.push(makeRequest(2, kChipIdRequest), now));
+    }
+    //client 1 is served once five quanta are saved up
+    EXPECT_EQ(std::vector<uint64_t>({2, 2, 2, 2, 1, 2, 2}), popAll(queue));
+}
+
+TEST(FairQueueUT, push_clientFieldSharesConnectionBudget)
+{
+    FairQueue queue;
+    queue.setRateLimit(1, 2);
+    Clock::time_point now = Clock::now();
+    //get_chipid with client 0, 1 and 2 on one connection
+    EXPECT_TRUE(queue.push(makeRequest(1, {0x12, 0x00, 0x00, 0x00}), now));
+    EXPECT_TRUE(queue.push(makeRequest(1, {0x12, 0x00, 0x00, 0x10}), now));
+    EXPECT_FALSE(queue.push(makeRequest(1, {0x12, 0x00, 0x00, 0x20}), now));
+
+    now += std::chrono::seconds(1);
+    EXPECT_TRUE(queue.push(makeRequest(1, {0x12, 0x00, 0x00, 0x30}), now));
+    EXPECT_FALSE(queue.push(makeRequest(1, {0x12, 0x00, 0x00, 0x40}), now));
+    //still one queue per client field, served in turns
+    EXPECT_EQ((size_t)3, queue.size());
+}
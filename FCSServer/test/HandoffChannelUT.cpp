@@ -0,0 +1,135 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "HandoffChannel.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char kHandoffSocketPath[] = "/tmp/fcsServerHandoffUT.sock";
+
+TEST(HandoffChannelUT, receive_passedFdAndData)
+{
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    HandoffChannel sender(sockets[0]);
+    HandoffChannel receiver(sockets[1]);
+    int pipeFds[2];
+    ASSERT_EQ(0, pipe(pipeFds));
+
+    std::vector<uint8_t> partialRequest {0x12, 0x00, 0x00};
+    EXPECT_TRUE(sender.send(
+        HandoffChannel::connection, pipeFds[1], partialRequest));
+    close(pipeFds[1]);
+
+    HandoffChannel::MessageType type;
+    int passedFd = -1;
+    std::vector<uint8_t> data;
+    ASSERT_TRUE(receiver.receive(type, passedFd, data));
+    EXPECT_EQ(HandoffChannel::connection, type);
+    EXPECT_EQ(partialRequest, data);
+    ASSERT_NE(-1, passedFd);
+
+    //passed descriptor refers to the same pipe
+    uint8_t byte = 0x5A;
+    EXPECT_EQ(1, write(passedFd, &byte, 1));
+    byte = 0;
+    EXPECT_EQ(1, read(pipeFds[0], &byte, 1));
+    EXPECT_EQ(0x5A, byte);
+    close(passedFd);
+    close(pipeFds[0]);
+}
+
+TEST(HandoffChannelUT, receive_messagesInOrderWithoutFd)
+{
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    HandoffChannel sender(sockets[0]);
+    HandoffChannel receiver(sockets[1]);
+    std::vector<uint8_t> removeSocketFile {0x01};
+    EXPECT_TRUE(sender.send(HandoffChannel::listenersDone, -1));
+    EXPECT_TRUE(sender.send(HandoffChannel::unixSocket, -1, removeSocketFile));
+
+    HandoffChannel::MessageType type;
+    int passedFd = 0;
+    std::vector<uint8_t> data {0xFF};
+    ASSERT_TRUE(receiver.receive(type, passedFd, data));
+    EXPECT_EQ(HandoffChannel::listenersDone, type);
+    EXPECT_EQ(-1, passedFd);
+    EXPECT_TRUE(data.empty());
+    ASSERT_TRUE(receiver.receive(type, passedFd, data));
+    EXPECT_EQ(HandoffChannel::unixSocket, type);
+    EXPECT_EQ(removeSocketFile, data);
+}
+
+TEST(HandoffChannelUT, receive_failsOnClosedPeerAndOversizedMessage)
+{
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    HandoffChannel receiver(sockets[1]);
+    //connection message header announcing 1 MB
+    uint8_t header[] = {0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00};
+    EXPECT_EQ((ssize_t)sizeof(header), write(sockets[0], header, sizeof(header)));
+
+    HandoffChannel::MessageType type;
+    int passedFd = -1;
+    std::vector<uint8_t> data;
+    EXPECT_FALSE(receiver.receive(type, passedFd, data));
+    close(sockets[0]);
+    EXPECT_FALSE(receiver.receive(type, passedFd, data));
+    EXPECT_EQ(-1, passedFd);
+}
+
+TEST(HandoffChannelUT, accept_connectionFromSameUser)
+{
+    int listenerFd = HandoffChannel::listen(kHandoffSocketPath);
+    ASSERT_NE(-1, listenerFd);
+    //nobody accepts yet, the connection waits in the backlog
+    HandoffChannel newProcess(HandoffChannel::connect(kHandoffSocketPath));
+    ASSERT_NE(-1, newProcess.getFd());
+    HandoffChannel runningProcess(HandoffChannel::accept(listenerFd));
+    ASSERT_NE(-1, runningProcess.getFd());
+
+    EXPECT_TRUE(runningProcess.send(HandoffChannel::done, -1));
+    HandoffChannel::MessageType type;
+    int passedFd = -1;
+    std::vector<uint8_t> data;
+    ASSERT_TRUE(newProcess.receive(type, passedFd, data));
+    EXPECT_EQ(HandoffChannel::done, type);
+
+    close(listenerFd);
+    unlink(kHandoffSocketPath);
+    EXPECT_EQ(-1, HandoffChannel::connect(kHandoffSocketPath));
+}
@@ -0,0 +1,234 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "MessageHandler.h"
+#include "ReactorPool.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static std::mutex handledMutex;
+// requests handled per reactor index of the connection token
+static std::map<uint32_t, uint32_t> requestsPerReactor;
+
+static void handleEchoMessage(
+    BufferView messageBuffer, ResponseMessage &response, uint64_t connectionToken)
+{
+    {
+        std::lock_guard<std::mutex> lock(handledMutex);
+        requestsPerReactor[(connectionToken >> 24) & 0xff]++;
+    }
+    response.setHeader(uint32_t(messageBuffer[3]) << 24);
+}
+
+/*
+Reactors of one process sharing a port, all driven from the test thread.
+*/
+class ReactorPoolUT : public ::testing::Test
+{
+    protected:
+        static const uint32_t kReactors = 2;
+        static const uint32_t kClients = 24;
+
+        void SetUp() override
+        {
+            requestsPerReactor.clear();
+            // port no socket is bound to right now
+            int socketFd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            socklen_t addressSize = sizeof(address);
+            bind(socketFd, (sockaddr*)&address, addressSize);
+            getsockname(socketFd, (sockaddr*)&address, &addressSize);
+            close(socketFd);
+            port = ntohs(address.sin_port);
+        }
+
+        void TearDown() override
+        {
+            executor.reset();
+            for (int clientFd : clientFds)
+            {
+                close(clientFd);
+            }
+        }
+
+        void startReactors(uint32_t workers)
+        {
+            MessageHandlers handlers { &handleEchoMessage, &handleBusyMessage,
+                &handleRetryLaterMessage, nullptr, nullptr, nullptr };
+            if (workers > 0)
+            {
+                executor = std::make_unique<RequestExecutor>(handlers, workers);
+                ASSERT_TRUE(executor->start());
+            }
+            config.reactors = kReactors;
+            for (uint32_t i = 0; i < kReactors; i++)
+            {
+                reactors[i].setConfig(ReactorPool::getReactorConfig(config));
+                reactors[i].setExecutor(executor.get());
+                reactors[i].setReactorIndex(i);
+                reactors[i].start(port, handlers);
+            }
+        }
+
+        // every client sends get_chipid with its own id
+        void connectClients()
+        {
+            for (uint32_t i = 0; i < kClients; i++)
+            {
+                int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in address = {};
+                address.sin_family = AF_INET;
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                address.sin_port = htons(port);
+                ASSERT_EQ(0, connect(clientFd, (sockaddr*)&address, sizeof(address)));
+                uint8_t request[] = {0x12, 0x00, 0x00, uint8_t(i & 0x0f)};
+                ASSERT_EQ((ssize_t)sizeof(request),
+                    send(clientFd, request, sizeof(request), MSG_NOSIGNAL));
+                clientFds.push_back(clientFd);
+            }
+        }
+
+        // runs all reactors until every client got a response or was
+        // disconnected, false on timeout
+        bool serveClients()
+        {
+            auto deadline = std::chrono::steady_clock::now()
+                + std::chrono::seconds(5);
+            while (responses.size() + disconnectedClients < kClients)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                for (TcpServer &reactor : reactors)
+                {
+                    reactor.runOnce(1);
+                }
+                for (uint32_t i = 0; i < kClients; i++)
+                {
+                    receive(i);
+                }
+            }
+            return true;
+        }
+
+        void receive(uint32_t client)
+        {
+            if (responses.count(client) > 0 || clientFds[client] == -1)
+            {
+                return;
+            }
+            uint8_t response[4];
+            ssize_t receivedSize = recv(clientFds[client],
+                response, sizeof(response), MSG_DONTWAIT);
+            if (receivedSize == (ssize_t)sizeof(response))
+            {
+                responses[client] = std::vector<uint8_t>(
+                    response, response + sizeof(response));
+            }
+            else if (receivedSize == 0
+                || (receivedSize == -1 && errno != EAGAIN))
+            {
+                close(clientFds[client]);
+                clientFds[client] = -1;
+                disconnectedClients++;
+            }
+        }
+
+        uint16_t port = 0;
+        ServerConfig config;
+        TcpServer reactors[kReactors];
+        std::unique_ptr<RequestExecutor> executor;
+        std::vector<int> clientFds;
+        std::map<uint32_t, std::vector<uint8_t>> responses;
+        uint32_t disconnectedClients = 0;
+};
+
+TEST(ReactorPoolConfigUT, getReactorConfig_connectionLimitSplit)
+{
+    ServerConfig config;
+    config.maxConnections = 20;
+    config.reactors = 3;
+    EXPECT_EQ((uint32_t)7, ReactorPool::getReactorConfig(config).maxConnections);
+    config.reactors = 1;
+    EXPECT_EQ((uint32_t)20, ReactorPool::getReactorConfig(config).maxConnections);
+    config.reactors = 0;
+    EXPECT_EQ((uint32_t)20, ReactorPool::getReactorConfig(config).maxConnections);
+}
+
+TEST_F(ReactorPoolUT, reuseport_connectionsSpreadAndAnsweredByTheirReactor)
+{
+    //room for all clients on either reactor
+    config.maxConnections = kClients * kReactors;
+    startReactors(2);
+    connectClients();
+    ASSERT_TRUE(serveClients());
+
+    //completions of the shared executor reach the reactor of the token
+    EXPECT_EQ((uint32_t)0, disconnectedClients);
+    for (uint32_t i = 0; i < kClients; i++)
+    {
+        EXPECT_EQ(std::vector<uint8_t>({0x00, 0x00, 0x00, uint8_t(i & 0x0f)}),
+            responses[i]);
+    }
+    //kernel spreads connections by hash, so each reactor gets some
+    std::lock_guard<std::mutex> lock(handledMutex);
+    EXPECT_EQ((size_t)kReactors, requestsPerReactor.size());
+    EXPECT_GT(requestsPerReactor[0], (uint32_t)0);
+    EXPECT_GT(requestsPerReactor[1], (uint32_t)0);
+}
+
+TEST_F(ReactorPoolUT, maxConnections_splitBetweenReactors)
+{
+    //one connection per reactor, requests handled inline
+    config.maxConnections = 2;
+    config.idleTimeoutInSeconds = 0;
+    startReactors(0);
+    connectClients();
+    ASSERT_TRUE(serveClients());
+
+    EXPECT_EQ((size_t)kReactors, responses.size());
+    EXPECT_EQ(kClients - kReactors, disconnectedClients);
+    std::lock_guard<std::mutex> lock(handledMutex);
+    EXPECT_EQ((uint32_t)1, requestsPerReactor[0]);
+    EXPECT_EQ((uint32_t)1, requestsPerReactor[1]);
+}
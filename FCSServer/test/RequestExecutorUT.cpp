@@ -0,0 +1,239 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "MessageHandler.h"
+#include "RequestExecutor.h"
+#include "Statistics.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <thread>
+#include <utility>
+
+//get_chipid with id 1, client 0
+static const std::vector<uint8_t> kChipIdRequest {0x12, 0x00, 0x00, 0x01};
+
+// answers without a device, header tells the request was handled
+static void handleTestMessage(
+    BufferView messageBuffer, ResponseMessage &response, uint64_t)
+{
+    response.setHeader(0x7f000000 | messageBuffer[3]);
+}
+
+// requests are held in service until the gate opens
+static std::mutex gateMutex;
+static std::condition_variable gateCondition;
+static bool gateOpen = false;
+static uint32_t requestsStarted = 0;
+
+static void handleGatedTestMessage(
+    BufferView messageBuffer, ResponseMessage &response, uint64_t connectionToken)
+{
+    {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        requestsStarted++;
+        gateCondition.notify_all();
+        gateCondition.wait(lock, []
+        {
+            return gateOpen;
+        });
+    }
+    handleTestMessage(messageBuffer, response, connectionToken);
+}
+
+static void setGateOpen(bool open)
+{
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        gateOpen = open;
+    }
+    gateCondition.notify_all();
+}
+
+static bool waitForRequestsStarted(uint32_t count)
+{
+    std::unique_lock<std::mutex> lock(gateMutex);
+    return gateCondition.wait_for(lock, std::chrono::seconds(5), [count]
+    {
+        return requestsStarted >= count;
+    });
+}
+
+static MessageHandlers getTestHandlers(bool gated = false)
+{
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        gateOpen = false;
+        requestsStarted = 0;
+    }
+    return MessageHandlers {
+        gated ? &handleGatedTestMessage : &handleTestMessage,
+        &handleBusyMessage, &handleRetryLaterMessage, nullptr, nullptr, nullptr };
+}
+
+// response bytes by connection token and request id
+typedef std::map<std::pair<uint64_t, uint8_t>, std::vector<uint8_t>> Responses;
+
+static Responses waitForCompletions(CompletionQueue &queue, size_t count)
+{
+    Responses responses;
+    std::vector<Completion> taken;
+    pollfd notification { queue.getNotificationFd(), POLLIN, 0 };
+    while (responses.size() < count && poll(&notification, 1, 1000) == 1)
+    {
+        queue.take(taken);
+        for (Completion &completion : taken)
+        {
+            responses[{ completion.connectionToken, completion.requestId }] =
+                completion.response.toVector();
+        }
+    }
+    return responses;
+}
+
+TEST(RequestExecutorUT, submit_clientOverRateAnsweredBusy)
+{
+    RequestExecutor executor(getTestHandlers(), 1);
+    executor.setRateLimit(1, 1);
+    CompletionQueue completionQueue;
+    ASSERT_TRUE(completionQueue.open());
+    ASSERT_TRUE(executor.start());
+
+    //other client field on the same connection takes from the same budget
+    std::vector<uint8_t> otherClientRequest {0x12, 0x00, 0x00, 0x12};
+    executor.submit(completionQueue, 1, 1, kChipIdRequest);
+    executor.submit(completionQueue, 1, 2, otherClientRequest);
+    executor.submit(completionQueue, 2, 1, kChipIdRequest);
+
+    Responses responses = waitForCompletions(completionQueue, 3);
+    ASSERT_EQ((size_t)3, responses.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}),
+        (responses[{1, 1}]));
+    EXPECT_EQ(std::vector<uint8_t>({0x05, 0x00, 0x00, 0x12}),
+        (responses[{1, 2}]));
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}),
+        (responses[{2, 1}]));
+}
+
+TEST(RequestExecutorUT, submit_completionReachesItsQueue)
+{
+    RequestExecutor executor(getTestHandlers(), 2);
+    CompletionQueue firstReactor;
+    CompletionQueue secondReactor;
+    ASSERT_TRUE(firstReactor.open());
+    ASSERT_TRUE(secondReactor.open());
+    ASSERT_TRUE(executor.start());
+
+    std::vector<uint8_t> secondRequest {0x12, 0x00, 0x00, 0x02};
+    executor.submit(firstReactor, 7, 1, kChipIdRequest);
+    executor.submit(secondReactor, 8, 2, secondRequest);
+
+    Responses firstResponses = waitForCompletions(firstReactor, 1);
+    ASSERT_EQ((size_t)1, firstResponses.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}),
+        (firstResponses[{7, 1}]));
+    Responses secondResponses = waitForCompletions(secondReactor, 1);
+    ASSERT_EQ((size_t)1, secondResponses.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x02, 0x00, 0x00, 0x7f}),
+        (secondResponses[{8, 2}]));
+}
+
+TEST(RequestExecutorUT, submit_tooManyPendingAnsweredRetryLater)
+{
+    RequestExecutor executor(getTestHandlers(true), 1);
+    executor.setLoadShedding(2, 0);
+    CompletionQueue completionQueue;
+    ASSERT_TRUE(completionQueue.open());
+    ASSERT_TRUE(executor.start());
+    uint64_t shedBefore = Statistics::get(Statistics::executorRequestsShedPending);
+
+    //one request in service and one queued stay below the threshold
+    executor.submit(completionQueue, 1, 1, kChipIdRequest);
+    ASSERT_TRUE(waitForRequestsStarted(1));
+    executor.submit(completionQueue, 2, 1, kChipIdRequest);
+    executor.submit(completionQueue, 3, 1, kChipIdRequest);
+    Responses shed = waitForCompletions(completionQueue, 1);
+    ASSERT_EQ((size_t)1, shed.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x06, 0x00, 0x00, 0x01}), (shed[{3, 1}]));
+    EXPECT_EQ(shedBefore + 1,
+        Statistics::get(Statistics::executorRequestsShedPending));
+
+    setGateOpen(true);
+    Responses served = waitForCompletions(completionQueue, 2);
+    ASSERT_EQ((size_t)2, served.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}), (served[{1, 1}]));
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}), (served[{2, 1}]));
+}
+
+TEST(RequestExecutorUT, submit_slowServiceAnsweredRetryLaterWhenWorkersBusy)
+{
+    RequestExecutor executor(getTestHandlers(true), 1);
+    executor.setLoadShedding(0, 1);
+    CompletionQueue completionQueue;
+    ASSERT_TRUE(completionQueue.open());
+    ASSERT_TRUE(executor.start());
+    uint64_t shedBefore =
+        Statistics::get(Statistics::executorRequestsShedServiceTime);
+
+    //a 20 ms request moves the average of 1/8 weight above 1 ms
+    executor.submit(completionQueue, 1, 1, kChipIdRequest);
+    ASSERT_TRUE(waitForRequestsStarted(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    setGateOpen(true);
+    ASSERT_EQ((size_t)1, waitForCompletions(completionQueue, 1).size());
+    setGateOpen(false);
+
+    //slow, but admitted while the worker is free
+    executor.submit(completionQueue, 2, 1, kChipIdRequest);
+    ASSERT_TRUE(waitForRequestsStarted(2));
+    //worker is busy now
+    executor.submit(completionQueue, 3, 1, kChipIdRequest);
+    Responses shed = waitForCompletions(completionQueue, 1);
+    ASSERT_EQ((size_t)1, shed.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x06, 0x00, 0x00, 0x01}), (shed[{3, 1}]));
+    EXPECT_EQ(shedBefore + 1,
+        Statistics::get(Statistics::executorRequestsShedServiceTime));
+
+    //below a higher threshold the request is queued instead
+    executor.setLoadShedding(0, 1000);
+    executor.submit(completionQueue, 4, 1, kChipIdRequest);
+    setGateOpen(true);
+    Responses served = waitForCompletions(completionQueue, 2);
+    ASSERT_EQ((size_t)2, served.size());
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}), (served[{2, 1}]));
+    EXPECT_EQ(std::vector<uint8_t>({0x01, 0x00, 0x00, 0x7f}), (served[{4, 1}]));
+}
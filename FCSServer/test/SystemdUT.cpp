@@ -0,0 +1,171 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "Systemd.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+Puts sockets where systemd passes them, from fd 3 on, and puts back
+whatever the test process had there.
+*/
+class SystemdUT : public ::testing::Test
+{
+    protected:
+        static const int kPassedFds = 2;
+        static const int kFirstFreeFd = 100;
+
+        void SetUp() override
+        {
+            for (int i = 0; i < kPassedFds; i++)
+            {
+                savedFds[i] = fcntl(3 + i, F_DUPFD_CLOEXEC, kFirstFreeFd);
+            }
+            for (int i = 0; i < kPassedFds; i++)
+            {
+                // socketpair may itself pick a free fd from 3 on
+                int sockets[2];
+                ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+                int passedSocket = fcntl(sockets[0], F_DUPFD, kFirstFreeFd);
+                close(sockets[0]);
+                close(sockets[1]);
+                ASSERT_EQ(3 + i, dup2(passedSocket, 3 + i));
+                close(passedSocket);
+            }
+        }
+
+        void TearDown() override
+        {
+            for (int i = 0; i < kPassedFds; i++)
+            {
+                if (savedFds[i] == -1)
+                {
+                    close(3 + i);
+                    continue;
+                }
+                dup2(savedFds[i], 3 + i);
+                close(savedFds[i]);
+            }
+            unsetenv("LISTEN_FDS");
+            unsetenv("LISTEN_PID");
+            unsetenv("NOTIFY_SOCKET");
+            unsetenv("WATCHDOG_USEC");
+            unsetenv("WATCHDOG_PID");
+        }
+
+        void setListenEnvironment(int count, pid_t pid)
+        {
+            setenv("LISTEN_FDS", std::to_string(count).c_str(), 1);
+            setenv("LISTEN_PID", std::to_string(pid).c_str(), 1);
+        }
+
+        int savedFds[kPassedFds];
+};
+
+TEST_F(SystemdUT, takeListenFds_passedToThisProcess)
+{
+    setListenEnvironment(kPassedFds, getpid());
+    EXPECT_EQ(std::vector<int>({3, 4}), Systemd::takeListenFds());
+    for (int fd = 3; fd < 3 + kPassedFds; fd++)
+    {
+        EXPECT_TRUE(fcntl(fd, F_GETFL) & O_NONBLOCK);
+        EXPECT_TRUE(fcntl(fd, F_GETFD) & FD_CLOEXEC);
+    }
+    //child processes do not take them again
+    EXPECT_EQ(nullptr, getenv("LISTEN_FDS"));
+    EXPECT_EQ(nullptr, getenv("LISTEN_PID"));
+    EXPECT_TRUE(Systemd::takeListenFds().empty());
+}
+
+TEST_F(SystemdUT, takeListenFds_otherProcessOrNoneIgnored)
+{
+    setListenEnvironment(kPassedFds, getpid() + 1);
+    EXPECT_TRUE(Systemd::takeListenFds().empty());
+    EXPECT_EQ(nullptr, getenv("LISTEN_FDS"));
+    EXPECT_FALSE(fcntl(3, F_GETFL) & O_NONBLOCK);
+
+    setListenEnvironment(0, getpid());
+    EXPECT_TRUE(Systemd::takeListenFds().empty());
+
+    setenv("LISTEN_PID", std::to_string(getpid()).c_str(), 1);
+    EXPECT_TRUE(Systemd::takeListenFds().empty());
+}
+
+TEST_F(SystemdUT, notify_sendsStateToNotifySocket)
+{
+    //abstract socket, named by a leading '@' in NOTIFY_SOCKET
+    std::string name = "@fcsServerSystemdUT" + std::to_string(getpid());
+    int receiverFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ASSERT_NE(-1, receiverFd);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    name.copy(address.sun_path, name.size());
+    address.sun_path[0] = '\0';
+    ASSERT_EQ(0, bind(receiverFd, (sockaddr*)&address,
+        offsetof(sockaddr_un, sun_path) + name.size()));
+    setenv("NOTIFY_SOCKET", name.c_str(), 1);
+
+    EXPECT_TRUE(Systemd::notify("READY=1"));
+    char state[64];
+    ssize_t receivedSize = recv(receiverFd, state, sizeof(state), MSG_DONTWAIT);
+    EXPECT_EQ("READY=1", std::string(state, receivedSize > 0 ? receivedSize : 0));
+    close(receiverFd);
+
+    //nobody listens at the address any more
+    EXPECT_FALSE(Systemd::notify("STOPPING=1"));
+}
+
+TEST_F(SystemdUT, notify_withoutNotifySocket)
+{
+    EXPECT_FALSE(Systemd::notify("READY=1"));
+    setenv("NOTIFY_SOCKET", "", 1);
+    EXPECT_FALSE(Systemd::notify("READY=1"));
+}
+
+TEST_F(SystemdUT, getWatchdogInterval_forThisProcessOnly)
+{
+    EXPECT_EQ((uint64_t)0, Systemd::getWatchdogIntervalInMicroseconds());
+    setenv("WATCHDOG_USEC", "2000000", 1);
+    EXPECT_EQ((uint64_t)2000000, Systemd::getWatchdogIntervalInMicroseconds());
+    setenv("WATCHDOG_PID", std::to_string(getpid()).c_str(), 1);
+    EXPECT_EQ((uint64_t)2000000, Systemd::getWatchdogIntervalInMicroseconds());
+    setenv("WATCHDOG_PID", std::to_string(getpid() + 1).c_str(), 1);
+    EXPECT_EQ((uint64_t)0, Systemd::getWatchdogIntervalInMicroseconds());
+}
@@ -0,0 +1,545 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "MessageHandler.h"
+#include "Statistics.h"
+#include "TcpServer.h"
+
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// requests are held by the test handler until their CommandHeader.id is
+// released, so the test decides the order in which they complete
+static std::mutex gateMutex;
+static std::condition_variable gateCondition;
+static uint16_t releasedIds = 0;
+static uint32_t requestsStarted = 0;
+// words of payload each response carries
+static uint32_t responsePayloadWords = 0;
+// copies taken after the gate, i.e. of buffers the reactor may have let go
+static std::vector<std::vector<uint8_t>> requestsHandled;
+// reactor thread only
+static uint32_t connectionsClosed = 0;
+
+// success with the client and id of the request, payload bytes count up
+// from the id
+static std::vector<uint8_t> makeResponse(
+    uint8_t clientAndId, uint32_t payloadWords = 0)
+{
+    uint32_t header = (payloadWords << 12) | (uint32_t(clientAndId) << 24);
+    std::vector<uint8_t> response(4 + payloadWords * 4);
+    for (size_t i = 0; i < response.size(); i++)
+    {
+        response[i] = i < 4 ? static_cast<uint8_t>(header >> (8 * i))
+            : static_cast<uint8_t>(clientAndId + i);
+    }
+    return response;
+}
+
+static void handleGatedMessage(
+    BufferView messageBuffer, ResponseMessage &response, uint64_t)
+{
+    uint8_t id = messageBuffer[3] & 0x0f;
+    std::unique_lock<std::mutex> lock(gateMutex);
+    requestsStarted++;
+    gateCondition.wait(lock, [id]
+    {
+        return (releasedIds & (1 << id)) != 0;
+    });
+    requestsHandled.emplace_back(
+        messageBuffer.data(), messageBuffer.data() + messageBuffer.size());
+    std::vector<uint8_t> encoded =
+        makeResponse(messageBuffer[3], responsePayloadWords);
+    response.setHeader(encoded[0] | encoded[1] << 8
+        | encoded[2] << 16 | uint32_t(encoded[3]) << 24);
+    response.setPayload(std::vector<uint8_t>(encoded.begin() + 4, encoded.end()));
+}
+
+static void handleTestClosedConnection(uint64_t)
+{
+    connectionsClosed++;
+}
+
+// get_chipid with payloadWords words of payload filled with fill
+// port no socket is bound to right now
+static uint16_t getFreePort()
+{
+    int socketFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    socklen_t addressSize = sizeof(address);
+    bind(socketFd, (sockaddr*)&address, addressSize);
+    getsockname(socketFd, (sockaddr*)&address, &addressSize);
+    close(socketFd);
+    return ntohs(address.sin_port);
+}
+
+static int connectToPort(uint16_t port)
+{
+    int socketFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(socketFd, (sockaddr*)&address, sizeof(address)) == -1)
+    {
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+static std::vector<uint8_t> makeRequest(
+    uint8_t clientAndId, uint32_t payloadWords = 0, uint8_t fill = 0)
+{
+    uint32_t header = 0x12 | (payloadWords << 12) | (uint32_t(clientAndId) << 24);
+    std::vector<uint8_t> request(4 + payloadWords * 4, fill);
+    for (size_t i = 0; i < 4; i++)
+    {
+        request[i] = static_cast<uint8_t>(header >> (8 * i));
+    }
+    return request;
+}
+
+class TcpServerUT : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            {
+                std::lock_guard<std::mutex> lock(gateMutex);
+                releasedIds = 0;
+                requestsStarted = 0;
+                requestsHandled.clear();
+                responsePayloadWords = 0;
+            }
+            connectionsClosed = 0;
+            // the reactor of a drain takes SIGINT and SIGTERM to a signalfd
+            pthread_sigmask(SIG_SETMASK, nullptr, &signalMask);
+            int sockets[2];
+            ASSERT_EQ(0, socketpair(AF_UNIX,
+                SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sockets));
+            clientFd = sockets[0];
+            serverFd = sockets[1];
+        }
+
+        void TearDown() override
+        {
+            // workers are joined before the server goes away
+            release(0xffff);
+            executor.reset();
+            if (clientFd != -1)
+            {
+                close(clientFd);
+            }
+            pthread_sigmask(SIG_SETMASK, &signalMask, nullptr);
+        }
+
+        void startServer(uint32_t workers, uint16_t port = 0)
+        {
+            MessageHandlers handlers { &handleGatedMessage,
+                &handleBusyMessage, &handleRetryLaterMessage,
+                &handleTestClosedConnection, nullptr, nullptr };
+            executor = std::make_unique<RequestExecutor>(handlers, workers);
+            ASSERT_TRUE(executor->start());
+            server.setConfig(config);
+            server.setExecutor(executor.get());
+            server.start(port, handlers);
+            ASSERT_TRUE(server.addConnectedSocket(serverFd));
+        }
+
+        void release(uint16_t ids)
+        {
+            {
+                std::lock_guard<std::mutex> lock(gateMutex);
+                releasedIds |= ids;
+            }
+            gateCondition.notify_all();
+        }
+
+        uint32_t getRequestsStarted()
+        {
+            std::lock_guard<std::mutex> lock(gateMutex);
+            return requestsStarted;
+        }
+
+        void send(const std::vector<uint8_t> &data)
+        {
+            ASSERT_EQ((ssize_t)data.size(),
+                write(clientFd, data.data(), data.size()));
+        }
+
+        // reads what the server sent so far into received
+        void receive()
+        {
+            uint8_t buffer[4096];
+            ssize_t receivedSize;
+            while ((receivedSize = read(clientFd, buffer, sizeof(buffer))) > 0)
+            {
+                received.insert(received.end(), buffer, buffer + receivedSize);
+            }
+        }
+
+        // runs the reactor until done, false on timeout
+        bool runUntil(std::function<bool()> done, int timeoutInSeconds = 5)
+        {
+            auto deadline = std::chrono::steady_clock::now()
+                + std::chrono::seconds(timeoutInSeconds);
+            while (!done())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                runOnce();
+            }
+            return true;
+        }
+
+        bool receiveUntil(size_t size)
+        {
+            return runUntil([this, size]
+            {
+                receive();
+                return received.size() >= size;
+            });
+        }
+
+        void runRounds(uint32_t rounds)
+        {
+            for (uint32_t i = 0; i < rounds; i++)
+            {
+                runOnce();
+            }
+        }
+
+        void runOnce()
+        {
+            if (!server.runOnce(10))
+            {
+                serverFinished = true;
+            }
+        }
+
+        // the server closed the connection, after any response
+        bool isClosedByServer()
+        {
+            uint8_t buffer[4096];
+            ssize_t receivedSize;
+            while ((receivedSize = read(clientFd, buffer, sizeof(buffer))) > 0)
+            {
+                received.insert(received.end(), buffer, buffer + receivedSize);
+            }
+            return receivedSize == 0;
+        }
+
+        ServerConfig config;
+        TcpServer server;
+        std::unique_ptr<RequestExecutor> executor;
+        int clientFd = -1;
+        int serverFd = -1;
+        std::vector<uint8_t> received;
+        // the process would end, the last reactor finished draining
+        bool serverFinished = false;
+        sigset_t signalMask;
+};
+
+TEST_F(TcpServerUT, pipelined_responsesSentInCompletionOrder)
+{
+    config.pipelineDepth = 4;
+    startServer(2);
+    std::vector<uint8_t> requests = makeRequest(0x01);
+    std::vector<uint8_t> second = makeRequest(0x02);
+    requests.insert(requests.end(), second.begin(), second.end());
+    send(requests);
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 2; }));
+
+    release(1 << 2);
+    ASSERT_TRUE(receiveUntil(4));
+    EXPECT_EQ(makeResponse(0x02), received);
+
+    release(1 << 1);
+    ASSERT_TRUE(receiveUntil(8));
+    EXPECT_EQ(makeResponse(0x01),
+        std::vector<uint8_t>(received.begin() + 4, received.end()));
+}
+
+TEST_F(TcpServerUT, pipelined_reusedIdWaitsForEarlierRequest)
+{
+    config.pipelineDepth = 4;
+    startServer(2);
+    //id 1 of client 0, then id 1 of client 1
+    std::vector<uint8_t> requests = makeRequest(0x01);
+    std::vector<uint8_t> second = makeRequest(0x11);
+    requests.insert(requests.end(), second.begin(), second.end());
+    send(requests);
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 1; }));
+    runRounds(5);
+    EXPECT_EQ((uint32_t)1, getRequestsStarted());
+
+    release(1 << 1);
+    ASSERT_TRUE(receiveUntil(8));
+    std::vector<uint8_t> expected = makeResponse(0x01);
+    std::vector<uint8_t> secondResponse = makeResponse(0x11);
+    expected.insert(expected.end(), secondResponse.begin(), secondResponse.end());
+    EXPECT_EQ(expected, received);
+}
+
+TEST_F(TcpServerUT, pipelined_readingStopsAtInputHighWaterMark)
+{
+    config.pipelineDepth = 2;
+    startServer(2);
+    int sendBufferSize = 1024 * 1024;
+    setsockopt(clientFd, SOL_SOCKET, SO_SNDBUF,
+        &sendBufferSize, sizeof(sendBufferSize));
+    std::vector<uint8_t> requests = makeRequest(0x01);
+    std::vector<uint8_t> second = makeRequest(0x02);
+    requests.insert(requests.end(), second.begin(), second.end());
+    send(requests);
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 2; }));
+
+    //4 KiB requests wait behind the two in flight until the socket is full
+    std::vector<uint8_t> large = makeRequest(0x03, 1023);
+    size_t largeRequests = 0;
+    while (largeRequests < 256
+        && write(clientFd, large.data(), large.size()) == (ssize_t)large.size())
+    {
+        largeRequests++;
+    }
+    ASSERT_GT(largeRequests * large.size(), (size_t)100 * 1024);
+    runRounds(20);
+
+    int unreadBytes = 0;
+    ASSERT_EQ(0, ioctl(serverFd, FIONREAD, &unreadBytes));
+    size_t bufferedBytes = largeRequests * large.size() - unreadBytes;
+    //reads of up to 10000 bytes stop once 64 KiB are buffered
+    EXPECT_GE(bufferedBytes, (size_t)64 * 1024);
+    EXPECT_LT(bufferedBytes, (size_t)64 * 1024 + 10000);
+    EXPECT_EQ((uint32_t)2, getRequestsStarted());
+
+    release(0xffff);
+    ASSERT_TRUE(receiveUntil((2 + largeRequests) * 4));
+    EXPECT_EQ((2 + largeRequests) * 4, received.size());
+    ASSERT_EQ(0, ioctl(serverFd, FIONREAD, &unreadBytes));
+    EXPECT_EQ(0, unreadBytes);
+}
+
+TEST_F(TcpServerUT, pipelined_closedConnectionKeepsRequestBuffers)
+{
+    config.pipelineDepth = 4;
+    startServer(2);
+    uint64_t droppedBefore = Statistics::get(Statistics::executorResponsesDropped);
+    std::vector<uint8_t> first = makeRequest(0x01, 2, 0xaa);
+    std::vector<uint8_t> second = makeRequest(0x02, 2, 0xbb);
+    send(first);
+    send(second);
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 2; }));
+
+    close(clientFd);
+    clientFd = -1;
+    ASSERT_TRUE(runUntil([this] { return fcntl(serverFd, F_GETFD) == -1; }));
+    //closing is reported once the requests in flight completed
+    EXPECT_EQ((uint32_t)0, connectionsClosed);
+
+    release(0xffff);
+    ASSERT_TRUE(runUntil([] { return connectionsClosed == 1; }));
+    EXPECT_EQ(droppedBefore + 2,
+        Statistics::get(Statistics::executorResponsesDropped));
+    std::lock_guard<std::mutex> lock(gateMutex);
+    ASSERT_EQ((size_t)2, requestsHandled.size());
+    EXPECT_TRUE(requestsHandled[0] == first || requestsHandled[0] == second);
+    EXPECT_TRUE(requestsHandled[1] == first || requestsHandled[1] == second);
+    EXPECT_NE(requestsHandled[0], requestsHandled[1]);
+}
+
+TEST_F(TcpServerUT, flushOutput_resumesPartialSendsInOrder)
+{
+    //one request at a time, responses of about 30 KB
+    responsePayloadWords = 7500;
+    size_t responseSize = 4 + responsePayloadWords * 4;
+    startServer(1);
+    int sendBufferSize = 4096;
+    setsockopt(serverFd, SOL_SOCKET, SO_SNDBUF,
+        &sendBufferSize, sizeof(sendBufferSize));
+    release(0xffff);
+    std::vector<uint8_t> requests;
+    std::vector<uint8_t> expected;
+    for (uint8_t id = 0; id < 10; id++)
+    {
+        std::vector<uint8_t> request = makeRequest(id);
+        requests.insert(requests.end(), request.begin(), request.end());
+        std::vector<uint8_t> response = makeResponse(id, responsePayloadWords);
+        expected.insert(expected.end(), response.begin(), response.end());
+    }
+    send(requests);
+
+    //client does not read, so requests stop once 64 KiB are not sent
+    runRounds(20);
+    uint32_t requestsServed = getRequestsStarted();
+    runRounds(10);
+    EXPECT_EQ(requestsServed, getRequestsStarted());
+    EXPECT_LT(requestsServed, (uint32_t)10);
+    int sentBytes = 0;
+    ASSERT_EQ(0, ioctl(clientFd, FIONREAD, &sentBytes));
+    EXPECT_GE(requestsServed * responseSize - sentBytes, (size_t)64 * 1024);
+
+    //reading resumes the partial send and then the remaining requests
+    ASSERT_TRUE(receiveUntil(expected.size()));
+    EXPECT_EQ((uint32_t)10, getRequestsStarted());
+    EXPECT_TRUE(expected == received);
+}
+
+TEST_F(TcpServerUT, completion_closedConnectionReleasedOnCompletion)
+{
+    startServer(1);
+    uint64_t droppedBefore = Statistics::get(Statistics::executorResponsesDropped);
+    std::vector<uint8_t> request = makeRequest(0x01, 2, 0xaa);
+    send(request);
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 1; }));
+
+    close(clientFd);
+    clientFd = -1;
+    ASSERT_TRUE(runUntil([this] { return fcntl(serverFd, F_GETFD) == -1; }));
+    EXPECT_EQ((uint32_t)0, connectionsClosed);
+
+    //worker still reads the request from the closed connection's buffer
+    release(0xffff);
+    ASSERT_TRUE(runUntil([] { return connectionsClosed == 1; }));
+    EXPECT_EQ(droppedBefore + 1,
+        Statistics::get(Statistics::executorResponsesDropped));
+    std::lock_guard<std::mutex> lock(gateMutex);
+    ASSERT_EQ((size_t)1, requestsHandled.size());
+    EXPECT_TRUE(request == requestsHandled[0]);
+}
+
+TEST_F(TcpServerUT, drain_finishesRequestsInFlightAndClosesListener)
+{
+    Drain drain;
+    ASSERT_TRUE(drain.open(1));
+    server.setDrain(&drain);
+    uint16_t port = getFreePort();
+    startServer(1, port);
+    int otherClientFd = connectToPort(port);
+    ASSERT_NE(-1, otherClientFd);
+    close(otherClientFd);
+    send(makeRequest(0x01));
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 1; }));
+
+    ASSERT_TRUE(drain.start(nullptr));
+    runRounds(2);
+    EXPECT_EQ(-1, connectToPort(port));
+    EXPECT_FALSE(serverFinished);
+
+    release(0xffff);
+    ASSERT_TRUE(runUntil([this] { return isClosedByServer(); }));
+    EXPECT_EQ(makeResponse(0x01), received);
+    ASSERT_TRUE(runUntil([this] { return serverFinished; }));
+}
+
+TEST_F(TcpServerUT, drain_timeoutAbandonsRequestsInFlight)
+{
+    Drain drain;
+    ASSERT_TRUE(drain.open(1));
+    server.setDrain(&drain);
+    config.drainTimeoutInSeconds = 1;
+    startServer(1);
+    send(makeRequest(0x01));
+    ASSERT_TRUE(runUntil([this] { return getRequestsStarted() == 1; }));
+
+    auto drainStart = std::chrono::steady_clock::now();
+    ASSERT_TRUE(drain.start(nullptr));
+    runRounds(5);
+    EXPECT_FALSE(isClosedByServer());
+
+    //request is still held, the connection is closed without a response
+    ASSERT_TRUE(runUntil([this] { return serverFinished; }));
+    EXPECT_GE(std::chrono::steady_clock::now() - drainStart,
+        std::chrono::seconds(1));
+    EXPECT_TRUE(isClosedByServer());
+    EXPECT_TRUE(received.empty());
+}
+
+TEST_F(TcpServerUT, unixSocket_servesRequestAndRemovesFileOnDrain)
+{
+    std::string path = "/tmp/fcsServerTcpServerUT"
+        + std::to_string(getpid()) + ".sock";
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    //socket file left behind by an earlier run is replaced
+    int staleFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(0, bind(staleFd, (sockaddr*)&address, sizeof(address)));
+    close(staleFd);
+
+    Drain drain;
+    ASSERT_TRUE(drain.open(1));
+    server.setDrain(&drain);
+    config.unixSocketPath = path;
+    startServer(1);
+    release(0xffff);
+    struct stat socketFile;
+    ASSERT_EQ(0, stat(path.c_str(), &socketFile));
+    EXPECT_TRUE(S_ISSOCK(socketFile.st_mode));
+    EXPECT_EQ((mode_t)0660, socketFile.st_mode & 0777);
+
+    int unixClientFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_EQ(0, connect(unixClientFd, (sockaddr*)&address, sizeof(address)));
+    std::vector<uint8_t> request = makeRequest(0x13);
+    ASSERT_EQ((ssize_t)request.size(),
+        write(unixClientFd, request.data(), request.size()));
+    std::vector<uint8_t> response(4);
+    ASSERT_TRUE(runUntil([&]
+    {
+        return recv(unixClientFd, response.data(), response.size(),
+            MSG_DONTWAIT) == (ssize_t)response.size();
+    }));
+    EXPECT_EQ(makeResponse(0x13), response);
+    close(unixClientFd);
+
+    ASSERT_TRUE(drain.start(nullptr));
+    runRounds(2);
+    EXPECT_EQ(-1, stat(path.c_str(), &socketFile));
+    EXPECT_EQ(ENOENT, errno);
+}
@@ -0,0 +1,113 @@
+/*
+This project, FPGA Crypto Service Server, is licensed as below
+
+***************************************************************************
+
+Copyright 2020-2023 Intel Corporation. All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************
+*/
+
+
+#include "gtest/gtest.h"
+
+#include "TimerQueue.h"
+
+typedef TimerQueue::Clock Clock;
+
+TEST(TimerQueueUT, popExpired_inDeadlineOrder)
+{
+    Clock::time_point now = Clock::now();
+    TimerQueue timers;
+    timers.schedule(3, now + std::chrono::seconds(3));
+    timers.schedule(1, now + std::chrono::seconds(1));
+    timers.schedule(4, now + std::chrono::seconds(4));
+    timers.schedule(2, now + std::chrono::seconds(2));
+
+    uint64_t timerId = 0;
+    EXPECT_FALSE(timers.popExpired(now, timerId));
+    for (uint64_t expected = 1; expected <= 3; expected++)
+    {
+        EXPECT_TRUE(timers.popExpired(now + std::chrono::seconds(3), timerId));
+        EXPECT_EQ(expected, timerId);
+    }
+    EXPECT_FALSE(timers.popExpired(now + std::chrono::seconds(3), timerId));
+    EXPECT_FALSE(timers.empty());
+}
+
+TEST(TimerQueueUT, schedule_existingTimerIsMoved)
+{
+    Clock::time_point now = Clock::now();
+    TimerQueue timers;
+    timers.schedule(1, now + std::chrono::seconds(1));
+    timers.schedule(2, now + std::chrono::seconds(2));
+    timers.schedule(3, now + std::chrono::seconds(3));
+    //later, then earlier than all others
+    timers.schedule(1, now + std::chrono::seconds(5));
+    timers.schedule(3, now);
+
+    uint64_t timerId = 0;
+    Clock::time_point later = now + std::chrono::seconds(10);
+    std::vector<uint64_t> order;
+    while (timers.popExpired(later, timerId))
+    {
+        order.push_back(timerId);
+    }
+    EXPECT_EQ(std::vector<uint64_t>({3, 2, 1}), order);
+    EXPECT_TRUE(timers.empty());
+}
+
+TEST(TimerQueueUT, cancel_removesOnlyThatTimer)
+{
+    Clock::time_point now = Clock::now();
+    TimerQueue timers;
+    for (uint64_t id = 1; id <= 5; id++)
+    {
+        timers.schedule(id, now + std::chrono::seconds(id));
+    }
+    timers.cancel(1);
+    timers.cancel(4);
+    timers.cancel(42);
+
+    uint64_t timerId = 0;
+    std::vector<uint64_t> order;
+    while (timers.popExpired(now + std::chrono::seconds(10), timerId))
+    {
+        order.push_back(timerId);
+    }
+    EXPECT_EQ(std::vector<uint64_t>({2, 3, 5}), order);
+}
+
+TEST(TimerQueueUT, getTimeoutInMilliseconds)
+{
+    Clock::time_point now = Clock::now();
+    TimerQueue timers;
+    EXPECT_EQ(-1, timers.getTimeoutInMilliseconds(now));
+    //rounded up, so the deadline has passed on wakeup
+    timers.schedule(1, now + std::chrono::microseconds(1500));
+    EXPECT_EQ(2, timers.getTimeoutInMilliseconds(now));
+    timers.schedule(2, now - std::chrono::seconds(1));
+    EXPECT_EQ(0, timers.getTimeoutInMilliseconds(now));
+}